@@ -4,8 +4,25 @@
 /// @copyright Public domain.
 /// @license CC0 1.0
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
-#include <string>
+#include <mutex>
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <signal.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+	#define CC0_UTEST_POSIX
+#endif
 #include "utest.h"
 
 void cc0::utest::UTestBase::IncrementAssertCount( void )
@@ -23,191 +40,3583 @@ void cc0::utest::UTestBase::Fail( void )
 	m_success = false;
 }
 
-cc0::utest::UTestBase::UTestBase( void ) : m_assert_count(0), m_success(true)
+void cc0::utest::UTestBase::RecordSoftFailure(int line)
+{
+	Fail();
+	SoftFailure &entry = m_soft[m_soft_count % SOFT_FAILURE_CAPACITY];
+	entry.assert_count = m_assert_count;
+	entry.line = line;
+	++m_soft_count;
+}
+
+cc0::utest::UTestBase::UTestBase( void ) : m_assert_count(0), m_soft_count(0), m_success(true)
+{}
+
+cc0::utest::UTestBase::~UTestBase( void )
+{
+	if (m_soft_count == 0) {
+		return;
+	}
+	std::ostream &out = cc0::utest::BeginReport();
+	const uint32_t shown = m_soft_count < SOFT_FAILURE_CAPACITY ? m_soft_count : SOFT_FAILURE_CAPACITY;
+	const uint32_t oldest = m_soft_count - shown;
+	out << m_soft_count << " soft failure" << (m_soft_count == 1 ? "" : "s");
+	if (shown < m_soft_count) {
+		out << " (last " << shown << ")";
+	}
+	out << ":";
+	for (uint32_t i = 0; i < shown; ++i) {
+		const SoftFailure &entry = m_soft[(oldest + i) % SOFT_FAILURE_CAPACITY];
+		out << (i == 0 ? " #" : ", #") << entry.assert_count << " @" << entry.line;
+	}
+	cc0::utest::EndReport(out);
+}
+
+bool cc0::utest::UTestBase::Succeeded( void ) const
+{
+	return m_success;
+}
+
+bool cc0::utest::UTestBase::Failed( void ) const
+{
+	return !m_success;
+}
+
+cc0::utest::UTestAsyncBase::UTestAsyncBase( void ) : UTestBase(), m_pending(true)
 {}
 
-bool cc0::utest::UTestBase::Succeeded( void ) const
+void cc0::utest::UTestAsyncBase::Done( void )
+{
+	m_pending = false;
+}
+
+bool cc0::utest::UTestAsyncBase::Pending( void ) const
+{
+	return m_pending;
+}
+
+/// @brief A contiguous growable array storing its elements by value. Growth doubles the backing storage so registration costs amortized constant allocations, iteration is cache-linear, and teardown frees a single block per array.
+template < typename type_t >
+class Array
+{
+private:
+	type_t   *m_data;
+	uint32_t  m_size;
+	uint32_t  m_capacity;
+
+	void Grow( void ) {
+		const uint32_t new_capacity = m_capacity > 0 ? m_capacity * 2 : 16;
+		type_t *new_data = static_cast<type_t*>(::operator new(sizeof(type_t) * new_capacity));
+		for (uint32_t i = 0; i < m_size; ++i) {
+			new (new_data + i) type_t(static_cast<type_t&&>(m_data[i]));
+			m_data[i].~type_t();
+		}
+		::operator delete(m_data);
+		m_data = new_data;
+		m_capacity = new_capacity;
+	}
+
+public:
+	Array( void ) : m_data(nullptr), m_size(0), m_capacity(0) {}
+	Array(Array<type_t> &&other) : m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity) {
+		other.m_data = nullptr;
+		other.m_size = 0;
+		other.m_capacity = 0;
+	}
+	~Array( void ) {
+		for (uint32_t i = 0; i < m_size; ++i) {
+			m_data[i].~type_t();
+		}
+		::operator delete(m_data);
+	}
+
+	Array<type_t> &operator=(Array<type_t> &&other) {
+		if (this != &other) {
+			for (uint32_t i = 0; i < m_size; ++i) {
+				m_data[i].~type_t();
+			}
+			::operator delete(m_data);
+			m_data = other.m_data;
+			m_size = other.m_size;
+			m_capacity = other.m_capacity;
+			other.m_data = nullptr;
+			other.m_size = 0;
+			other.m_capacity = 0;
+		}
+		return *this;
+	}
+
+	Array(const Array<type_t>&) = delete;
+	Array<type_t> &operator=(const Array<type_t>&) = delete;
+
+	void Add(type_t item) {
+		if (m_size == m_capacity) {
+			Grow();
+		}
+		new (m_data + m_size) type_t(static_cast<type_t&&>(item));
+		++m_size;
+	}
+
+	uint32_t Size( void ) const { return m_size; }
+
+	type_t &operator[](uint32_t i) { return m_data[i]; }
+	const type_t &operator[](uint32_t i) const { return m_data[i]; }
+};
+
+/// @brief Reads the monotonic wall clock in nanoseconds.
+static uint64_t WallNowNs( void )
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// @brief Reads the calling thread's consumed CPU time in nanoseconds. Returns 0 where the platform offers no cheap thread clock.
+static uint64_t CpuNowNs( void )
+{
+#if defined(CC0_UTEST_POSIX)
+	timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+		return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+	}
+#endif
+	return 0;
+}
+
+/// @brief Prints a nanosecond duration as milliseconds with two decimals.
+static void PrintMs(std::ostream &out, uint64_t ns)
+{
+	const uint64_t hundredths = (ns + 5000) / 10000;
+	out << (hundredths / 100) << "." << char('0' + (hundredths / 10) % 10) << char('0' + hundredths % 10) << " ms";
+}
+
+struct TestItem
+{
+	bool        (*test)();
+	const cc0::utest::AsyncTest *async; // The slice-driving hooks of an asynchronous test, or null for a regular test.
+	const cc0::utest::ParamTest *param; // The body and parameter table of a parameterized test, or null for a regular test.
+	const char  *name;   // Points at the string literal handed over by the registration macro; never owned or copied.
+	uint32_t    name_len;
+	bool        must_pass;
+	bool        enabled; // Whether the active run selected this test. Cleared by sharding and filtering, restored after the run.
+	uint32_t    timeout_ms; // The deadline of this test in milliseconds. 0 falls back to the default deadline of the run.
+	uint64_t    key;     // Stable hash of the context and test names, used to key persistent per-test data.
+	uint64_t    wall_ns; // Wall-clock duration of the last run of this test.
+	uint64_t    cpu_ns;  // CPU time consumed by the last run of this test.
+	uint64_t    alloc_count;  // Allocations reported during the last run of this test. Only filled when memory tracking is on.
+	uint64_t    peak_bytes;   // Peak tracked bytes above the level at test entry. Only filled when memory tracking is on.
+	int64_t     leaked_bytes; // Tracked bytes live at test exit minus those live at entry. Only filled when memory tracking is on.
+	int8_t      last_result; // -1 if the test has not run this process, otherwise 0 for fail and 1 for pass.
+	bool        last_flaky;  // Whether the last pass of this test needed a retry.
+
+	TestItem( void ) = default; // Uninitialized; only used for scratch buffers while reordering the registry.
+	TestItem(bool (*fn)(), const char *test_name, uint32_t test_name_len, bool test_must_pass = false, uint32_t test_timeout_ms = 0) : test(fn), async(nullptr), param(nullptr), name(test_name), name_len(test_name_len), must_pass(test_must_pass), enabled(true), timeout_ms(test_timeout_ms), key(0), wall_ns(0), cpu_ns(0), alloc_count(0), peak_bytes(0), leaked_bytes(0), last_result(-1), last_flaky(false) {}
+};
+
+/// @brief The memory counters the allocator under test reports into through CountAlloc/CountFree. Thread-local so every runner thread and worker process attributes allocations to the test it is running without synchronization.
+struct MemCounters
+{
+	uint64_t alloc_count; // Total allocations reported on this thread.
+	uint64_t live_bytes;  // Tracked bytes currently allocated on this thread.
+	uint64_t peak_bytes;  // Highest live_bytes seen since the last per-test reset.
+};
+
+static thread_local MemCounters g_mem_counters = { 0, 0, 0 };
+
+// Whether the active run snapshots and reports the memory counters around each test. Atomic because an executor thread abandoned on a timeout may still be inside TimedCall when the run tears the flag down or the next run re-assigns it; each side only needs its own value, so relaxed ordering suffices.
+static std::atomic<bool> g_track_memory(false);
+
+void cc0::utest::CountAlloc(uint64_t bytes)
+{
+	MemCounters &mem = g_mem_counters;
+	++mem.alloc_count;
+	mem.live_bytes += bytes;
+	if (mem.live_bytes > mem.peak_bytes) {
+		mem.peak_bytes = mem.live_bytes;
+	}
+}
+
+void cc0::utest::CountFree(uint64_t bytes)
+{
+	g_mem_counters.live_bytes -= bytes;
+}
+
+/// @brief Invokes a test function and records its result, wall-clock and CPU durations, and (when tracking is on) the memory counter deltas on the test.
+static bool TimedCall(TestItem &test)
+{
+	MemCounters &mem = g_mem_counters;
+	MemCounters before = { 0, 0, 0 };
+	// Read once: the flag must not change between the snapshot and the delta below, and an abandoned executor may observe the teardown of the run mid-test.
+	const bool track = g_track_memory.load(std::memory_order_relaxed);
+	if (track) {
+		before = mem;
+		mem.peak_bytes = mem.live_bytes; // Restrict the peak to this test only.
+	}
+	const uint64_t wall = WallNowNs();
+	const uint64_t cpu = CpuNowNs();
+	const bool passed = test.test();
+	test.cpu_ns = CpuNowNs() - cpu;
+	test.wall_ns = WallNowNs() - wall;
+	test.last_result = passed ? 1 : 0;
+	if (track) {
+		test.alloc_count = mem.alloc_count - before.alloc_count;
+		test.peak_bytes = mem.peak_bytes - before.live_bytes;
+		test.leaked_bytes = int64_t(mem.live_bytes) - int64_t(before.live_bytes);
+	}
+	return passed;
+}
+
+// The deadline in milliseconds applied to tests without their own. 0 disables deadlines.
+static uint32_t g_default_timeout_ms = 0;
+
+/// @brief Returns the deadline of a test in milliseconds, falling back to the default deadline of the run. 0 means no deadline.
+static uint32_t EffectiveTimeoutMs(const TestItem &test)
+{
+	return test.timeout_ms != 0 ? test.timeout_ms : g_default_timeout_ms;
+}
+
+// The number of failures the run may still record before no further test is started. Effectively unbounded unless the run sets a cutoff.
+static std::atomic<int64_t> g_failure_budget(int64_t(1) << 62);
+
+/// @brief Counts one failure against the optional failure cutoff of the run.
+static void CountFailure( void )
+{
+	g_failure_budget.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/// @brief Returns whether the failure cutoff has been reached and no further test should start.
+static bool StopRequested( void )
+{
+	return g_failure_budget.load(std::memory_order_relaxed) <= 0;
+}
+
+/// @brief A companion thread that runs test bodies handed to it by a runner thread, letting the runner wait with a deadline and abandon a hung test. One executor lives per runner thread and is only replaced after a timeout, so the fast path pays no thread creation.
+class TestExecutor
+{
+private:
+	std::mutex               m_lock;
+	std::condition_variable  m_cv;
+	TestItem                *m_test;
+	TestItem                 m_scratch; // The private copy the test executes on, so a late completion after abandonment never touches the shared registry item.
+	bool                     m_result;
+	bool                     m_done;
+	bool                     m_quit;
+	bool                     m_abandoned;
+	std::thread              m_thread;
+
+	void Loop( void ) {
+		std::unique_lock<std::mutex> lock(m_lock);
+		while (true) {
+			m_cv.wait(lock, [this]( void ) -> bool { return m_test != nullptr || m_quit; });
+			if (m_quit) {
+				return;
+			}
+			TestItem scratch = *m_test;
+			lock.unlock();
+			const bool result = TimedCall(scratch);
+			lock.lock();
+			m_test = nullptr;
+			m_scratch = scratch;
+			m_result = result;
+			m_done = true;
+			if (m_abandoned) {
+				// The runner gave up on this test and moved to a fresh executor. The results die with this thread; the runner has already recorded the timeout. This executor is leaked by design; just end the thread.
+				return;
+			}
+			m_cv.notify_all();
+		}
+	}
+
+public:
+	TestExecutor( void ) : m_test(nullptr), m_result(false), m_done(false), m_quit(false), m_abandoned(false) {
+		m_thread = std::thread(&TestExecutor::Loop, this);
+	}
+
+	~TestExecutor( void ) {
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_quit = true;
+		}
+		m_cv.notify_all();
+		if (m_thread.joinable()) {
+			m_thread.join();
+		}
+	}
+
+	/// @brief Runs the test on the companion thread. Returns false if the deadline expired, in which case this executor must not be reused.
+	bool Run(TestItem &test, uint32_t timeout_ms, bool &passed) {
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_test = &test;
+		m_done = false;
+		m_cv.notify_all();
+		if (!m_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]( void ) -> bool { return m_done; })) {
+			m_abandoned = true;
+			m_thread.detach();
+			return false;
+		}
+		// Copied out under the lock; an abandoned executor never reaches here, so its late results are discarded.
+		test = m_scratch;
+		passed = m_result;
+		return true;
+	}
+};
+
+/// @brief Runs a test, enforcing its deadline through the calling thread's executor when one applies. A timed-out test is abandoned, recorded as failed with its deadline as duration, and flagged through timed_out.
+static bool RunGuarded(TestItem &test, bool &timed_out)
+{
+	static thread_local TestExecutor *executor = nullptr;
+
+	timed_out = false;
+	const uint32_t timeout_ms = EffectiveTimeoutMs(test);
+	if (timeout_ms == 0) {
+		return TimedCall(test);
+	}
+	if (executor == nullptr) {
+		executor = new TestExecutor;
+	}
+	bool passed = false;
+	if (!executor->Run(test, timeout_ms, passed)) {
+		executor = new TestExecutor; // The old executor is still blocked in the hung test and is intentionally leaked.
+		test.last_result = 0;
+		test.wall_ns = uint64_t(timeout_ms) * 1000000ull;
+		timed_out = true;
+		return false;
+	}
+	return passed;
+}
+
+// The retry budget of the active run: extra attempts a failed test gets before its failure stands, and the delay before the first retry (doubled per attempt taken).
+static uint32_t g_retry_count = 0;
+static uint32_t g_retry_backoff_ms = 0;
+
+/// @brief Sleeps for the backoff of the given retry attempt: the configured delay, doubled per attempt already taken.
+static void RetryBackoff(uint32_t attempt)
+{
+	if (g_retry_backoff_ms > 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(uint64_t(g_retry_backoff_ms) << attempt));
+	}
+}
+
+/// @brief Runs a test through the guarded executor, re-running just this failed test in place up to the retry budget of the run. The suite keeps going with its warm state; nothing else re-executes. A pass that needed more than one attempt is flagged flaky, and the recorded duration is that of the deciding attempt.
+static bool RunWithRetry(TestItem &test, bool &timed_out, bool &flaky)
+{
+	bool passed = RunGuarded(test, timed_out);
+	for (uint32_t attempt = 0; !passed && attempt < g_retry_count && !StopRequested(); ++attempt) {
+		RetryBackoff(attempt);
+		timed_out = false;
+		passed = RunGuarded(test, timed_out);
+		if (passed) {
+			flaky = true;
+		}
+	}
+	return passed;
+}
+
+/// @brief Hashes a window of the test function's machine code. Unchanged test code keeps its fingerprint across rebuilds; any divergence (including a changed fingerprint for unchanged code due to relocation) errs toward re-running the test.
+static uint64_t FingerprintFunction(bool (*fn)())
+{
+	const uint8_t *code = reinterpret_cast<const uint8_t*>(fn);
+	// The window must not cross out of the entry's page: a function within 256 bytes of the end of the mapped code segment would otherwise fault the read. Stopping short only narrows the window, which at worst re-runs a test whose unhashed tail changed.
+#if defined(CC0_UTEST_POSIX)
+	const uintptr_t page_size = uintptr_t(sysconf(_SC_PAGESIZE));
+#else
+	const uintptr_t page_size = 4096;
+#endif
+	const uintptr_t remaining = page_size - (reinterpret_cast<uintptr_t>(code) & (page_size - 1));
+	const uintptr_t window = remaining < 256 ? remaining : 256;
+	uint64_t h = 14695981039346656037ull;
+	for (uintptr_t i = 0; i < window; ++i) {
+		h = (h ^ uint64_t(code[i])) * 1099511628211ull;
+	}
+	return h;
+}
+
+/// @brief One persisted per-test record in the result cache.
+struct CacheRecord
+{
+	uint64_t key;
+	uint64_t fingerprint;
+	uint64_t wall_ns;
+	uint32_t fail_count;  // Consecutive failures; reset on pass.
+	uint32_t run_count;   // Runs recorded into this record since it was created.
+	uint32_t flaky_count; // Runs whose pass needed a retry. flaky_count over run_count is the flake rate of the test.
+	uint8_t  passed;
+	uint8_t  pad[3];
+};
+
+/// @brief An open-addressing table of per-test cache records persisted between runs as a flat binary file. A key of 0 marks an empty slot; real keys hashing to 0 are nudged to 1.
+class ResultCache
+{
+private:
+	CacheRecord *m_slots;
+	uint32_t     m_capacity;
+	uint32_t     m_used;
+
+	void Grow( void ) {
+		const uint32_t new_capacity = m_capacity > 0 ? m_capacity * 2 : 1024;
+		CacheRecord *new_slots = new CacheRecord[new_capacity]();
+		for (uint32_t i = 0; i < m_capacity; ++i) {
+			if (m_slots[i].key != 0) {
+				uint32_t at = uint32_t(m_slots[i].key) & (new_capacity - 1);
+				while (new_slots[at].key != 0) {
+					at = (at + 1) & (new_capacity - 1);
+				}
+				new_slots[at] = m_slots[i];
+			}
+		}
+		delete [] m_slots;
+		m_slots = new_slots;
+		m_capacity = new_capacity;
+	}
+
+public:
+	ResultCache( void ) : m_slots(nullptr), m_capacity(0), m_used(0) {}
+	~ResultCache( void ) { delete [] m_slots; }
+
+	const CacheRecord *Find(uint64_t key) const {
+		if (key == 0) {
+			key = 1;
+		}
+		if (m_capacity == 0) {
+			return nullptr;
+		}
+		uint32_t i = uint32_t(key) & (m_capacity - 1);
+		while (m_slots[i].key != 0) {
+			if (m_slots[i].key == key) {
+				return &m_slots[i];
+			}
+			i = (i + 1) & (m_capacity - 1);
+		}
+		return nullptr;
+	}
+
+	CacheRecord &FindOrAdd(uint64_t key) {
+		if (key == 0) {
+			key = 1;
+		}
+		if (m_used * 10 >= m_capacity * 7) {
+			Grow();
+		}
+		uint32_t i = uint32_t(key) & (m_capacity - 1);
+		while (m_slots[i].key != 0 && m_slots[i].key != key) {
+			i = (i + 1) & (m_capacity - 1);
+		}
+		if (m_slots[i].key == 0) {
+			m_slots[i].key = key;
+			++m_used;
+		}
+		return m_slots[i];
+	}
+
+	uint32_t Used( void ) const { return m_used; }
+
+	bool Load(const char *path) {
+		std::FILE *fp = std::fopen(path, "rb");
+		if (fp == nullptr) {
+			return false;
+		}
+		uint32_t header[4] = { 0, 0, 0, 0 };
+		bool ok = std::fread(header, sizeof(header), 1, fp) == 1 && header[0] == 0x30435455 && header[1] == 2;
+		for (uint32_t i = 0; ok && i < header[2]; ++i) {
+			CacheRecord rec;
+			ok = std::fread(&rec, sizeof(rec), 1, fp) == 1;
+			if (ok) {
+				FindOrAdd(rec.key) = rec;
+			}
+		}
+		std::fclose(fp);
+		return ok;
+	}
+
+	bool Save(const char *path) const {
+		std::FILE *fp = std::fopen(path, "wb");
+		if (fp == nullptr) {
+			return false;
+		}
+		const uint32_t header[4] = { 0x30435455, 2, m_used, 0 };
+		bool ok = std::fwrite(header, sizeof(header), 1, fp) == 1;
+		for (uint32_t i = 0; ok && i < m_capacity; ++i) {
+			if (m_slots[i].key != 0) {
+				ok = std::fwrite(&m_slots[i], sizeof(CacheRecord), 1, fp) == 1;
+			}
+		}
+		std::fclose(fp);
+		return ok;
+	}
+};
+
+// The persistent result cache of the active run, if any, and whether cached passes may be skipped.
+static ResultCache *g_active_cache = nullptr;
+static bool         g_incremental  = false;
+
+/// @brief Checks whether the test may be skipped as a cached pass, restoring the cached duration on the test if so.
+static bool CachedPass(TestItem &test)
+{
+	if (!g_incremental || g_active_cache == nullptr) {
+		return false;
+	}
+	const CacheRecord *rec = g_active_cache->Find(test.key);
+	if (rec != nullptr && rec->passed != 0 && rec->fingerprint == FingerprintFunction(test.test)) {
+		test.wall_ns = rec->wall_ns;
+		return true;
+	}
+	return false;
+}
+
+/// @brief The lifecycle states a journal record can hold.
+enum JournalStatus
+{
+	JOURNAL_STARTED = 0, // Appended before the test runs; a journal ending on this record died inside the test.
+	JOURNAL_PASSED  = 1,
+	JOURNAL_FAILED  = 2
+};
+
+/// @brief One fixed-size record in the write-ahead result journal.
+struct JournalRecord
+{
+	uint64_t key;
+	uint64_t wall_ns;
+	uint64_t cpu_ns;
+	uint8_t  status;
+	uint8_t  pad[7];
+};
+
+/// @brief An append-only write-ahead journal of per-test outcomes enabling crash-resumable runs. Each test appends a started record before running and an outcome record after, so a run that dies mid-test leaves evidence of the culprit. Opening replays any existing records into an open-addressing table (later records win, so an outcome overrides its started record); the run skips every test with a replayed outcome. Appends are batched and fsynced every N records, so a crash loses at most the last batch and those tests simply run again.
+class ResultJournal
+{
+private:
+	JournalRecord *m_slots;
+	uint32_t       m_capacity;
+	uint32_t       m_used;
+	std::FILE     *m_file;
+	std::mutex     m_lock; // Serializes appends from concurrent workers.
+	uint32_t       m_pending;
+	uint32_t       m_sync_every;
+
+	void Grow( void ) {
+		const uint32_t new_capacity = m_capacity > 0 ? m_capacity * 2 : 1024;
+		JournalRecord *new_slots = new JournalRecord[new_capacity]();
+		for (uint32_t i = 0; i < m_capacity; ++i) {
+			if (m_slots[i].key != 0) {
+				uint32_t at = uint32_t(m_slots[i].key) & (new_capacity - 1);
+				while (new_slots[at].key != 0) {
+					at = (at + 1) & (new_capacity - 1);
+				}
+				new_slots[at] = m_slots[i];
+			}
+		}
+		delete [] m_slots;
+		m_slots = new_slots;
+		m_capacity = new_capacity;
+	}
+
+	JournalRecord &FindOrAdd(uint64_t key) {
+		if (key == 0) {
+			key = 1;
+		}
+		if (m_used * 10 >= m_capacity * 7) {
+			Grow();
+		}
+		uint32_t i = uint32_t(key) & (m_capacity - 1);
+		while (m_slots[i].key != 0 && m_slots[i].key != key) {
+			i = (i + 1) & (m_capacity - 1);
+		}
+		if (m_slots[i].key == 0) {
+			m_slots[i].key = key;
+			++m_used;
+		}
+		return m_slots[i];
+	}
+
+	void Sync( void ) {
+		std::fflush(m_file);
+#if defined(CC0_UTEST_POSIX)
+		fsync(fileno(m_file));
+#endif
+		m_pending = 0;
+	}
+
+public:
+	ResultJournal( void ) : m_slots(nullptr), m_capacity(0), m_used(0), m_file(nullptr), m_pending(0), m_sync_every(16) {}
+	~ResultJournal( void ) {
+		Close();
+		delete [] m_slots;
+	}
+
+	bool Open(const char *path, uint32_t sync_every) {
+		if (sync_every > 0) {
+			m_sync_every = sync_every;
+		}
+		long valid_bytes = 0;
+		long total_bytes = 0;
+		std::FILE *fp = std::fopen(path, "rb");
+		if (fp != nullptr) {
+			uint32_t header[4] = { 0, 0, 0, 0 };
+			bool ok = std::fread(header, sizeof(header), 1, fp) == 1 && header[0] == 0x304A5455 && header[1] == 1;
+			if (ok) {
+				valid_bytes = long(sizeof(header));
+			}
+			JournalRecord rec;
+			while (ok && std::fread(&rec, sizeof(rec), 1, fp) == 1) {
+				FindOrAdd(rec.key) = rec;
+				valid_bytes += long(sizeof(rec));
+			}
+			std::fseek(fp, 0, SEEK_END);
+			total_bytes = std::ftell(fp);
+			std::fclose(fp);
+		}
+		if (total_bytes != valid_bytes) {
+			// A crash mid-append leaves a torn record at the tail; appending after it would shift the fixed-size framing and make every later record of the next resume misread. Rewrite the replayed state so the file ends on a whole record again.
+			m_file = std::fopen(path, "wb");
+			if (m_file == nullptr) {
+				return false;
+			}
+			const uint32_t header[4] = { 0x304A5455, 1, 0, 0 };
+			std::fwrite(header, sizeof(header), 1, m_file);
+			for (uint32_t i = 0; i < m_capacity; ++i) {
+				if (m_slots[i].key != 0) {
+					std::fwrite(&m_slots[i], sizeof(m_slots[i]), 1, m_file);
+				}
+			}
+			Sync();
+			return true;
+		}
+		m_file = std::fopen(path, "ab");
+		if (m_file == nullptr) {
+			return false;
+		}
+		if (std::ftell(m_file) == 0) {
+			const uint32_t header[4] = { 0x304A5455, 1, 0, 0 };
+			std::fwrite(header, sizeof(header), 1, m_file);
+		}
+		return true;
+	}
+
+	const JournalRecord *Find(uint64_t key) const {
+		if (key == 0) {
+			key = 1;
+		}
+		if (m_capacity == 0) {
+			return nullptr;
+		}
+		uint32_t i = uint32_t(key) & (m_capacity - 1);
+		while (m_slots[i].key != 0) {
+			if (m_slots[i].key == key) {
+				return &m_slots[i];
+			}
+			i = (i + 1) & (m_capacity - 1);
+		}
+		return nullptr;
+	}
+
+	void Append(uint64_t key, uint8_t status, uint64_t wall_ns, uint64_t cpu_ns) {
+		std::lock_guard<std::mutex> guard(m_lock);
+		const JournalRecord rec = { key != 0 ? key : 1, wall_ns, cpu_ns, status, { 0, 0, 0, 0, 0, 0, 0 } };
+		std::fwrite(&rec, sizeof(rec), 1, m_file);
+		// Flushing every record makes it survive a crash of this process; the batched fsync below is only for machine-level durability.
+		std::fflush(m_file);
+		if (++m_pending >= m_sync_every) {
+			Sync();
+		}
+	}
+
+	void Close( void ) {
+		if (m_file != nullptr) {
+			std::lock_guard<std::mutex> guard(m_lock);
+			Sync();
+			std::fclose(m_file);
+			m_file = nullptr;
+		}
+	}
+};
+
+// The write-ahead result journal of the active run, if any.
+static ResultJournal *g_active_journal = nullptr;
+
+/// @brief Appends the started record of a test to the active journal, if any.
+static void JournalStart(const TestItem &test)
+{
+	if (g_active_journal != nullptr) {
+		g_active_journal->Append(test.key, JOURNAL_STARTED, 0, 0);
+	}
+}
+
+/// @brief Appends the outcome record of a test to the active journal, if any.
+static void JournalFinish(const TestItem &test, bool passed)
+{
+	if (g_active_journal != nullptr) {
+		g_active_journal->Append(test.key, passed ? JOURNAL_PASSED : JOURNAL_FAILED, test.wall_ns, test.cpu_ns);
+	}
+}
+
+// The report format of the active run.
+static cc0::utest::OutputFormat g_format = cc0::utest::OUTPUT_CONSOLE;
+
+// Set while test bodies are replayed as probes whose results are discarded, so their diagnostics are dropped instead of interleaving with the probe verdicts.
+static bool g_mute_reports = false;
+
+/// @brief A stream buffer collecting test output into a fixed internal buffer that is handed to the destination in single large writes instead of one write per token. Flushing is driven by the run loops at test-line and context granularity.
+class OutputWriter : public std::streambuf
+{
+private:
+	char                  m_buffer[1 << 16];
+	std::FILE            *m_stream;
+	std::recursive_mutex  m_lock; // Protects the buffer when worker threads emit diagnostics concurrently.
+	char                  m_last;  // The last character handed to the stream, so the run loops can tell whether output sits mid-line.
+
+	void WriteOut(const char *data, size_t size) {
+#if defined(CC0_UTEST_POSIX)
+		const int fd = fileno(m_stream);
+		while (size > 0) {
+			const ssize_t written = ::write(fd, data, size);
+			if (written <= 0) {
+				break;
+			}
+			data += written;
+			size -= size_t(written);
+		}
+#else
+		std::fwrite(data, 1, size, m_stream);
+		std::fflush(m_stream);
+#endif
+	}
+
+protected:
+	int overflow(int c) {
+		std::lock_guard<std::recursive_mutex> guard(m_lock);
+		FlushBuffer();
+		if (c != EOF) {
+			*pptr() = char(c);
+			pbump(1);
+			m_last = char(c);
+		}
+		return c;
+	}
+
+	std::streamsize xsputn(const char *data, std::streamsize size) {
+		std::lock_guard<std::recursive_mutex> guard(m_lock);
+		for (std::streamsize i = 0; i < size; ++i) {
+			if (pptr() == epptr()) {
+				FlushBuffer();
+			}
+			*pptr() = data[i];
+			pbump(1);
+		}
+		if (size > 0) {
+			m_last = data[size - 1];
+		}
+		return size;
+	}
+
+	int sync( void ) {
+		std::lock_guard<std::recursive_mutex> guard(m_lock);
+		FlushBuffer();
+		return 0;
+	}
+
+public:
+	OutputWriter( void ) : m_stream(stdout), m_last('\n') {
+		setp(m_buffer, m_buffer + sizeof(m_buffer) - 1);
+#if defined(CC0_UTEST_POSIX)
+		std::fflush(m_stream);
+#endif
+	}
+	~OutputWriter( void ) {
+		FlushBuffer();
+	}
+
+	void SetStream(std::FILE *stream) {
+		FlushBuffer();
+		m_stream = stream;
+#if defined(CC0_UTEST_POSIX)
+		std::fflush(m_stream);
+#endif
+	}
+
+	void FlushBuffer( void ) {
+		const size_t size = size_t(pptr() - pbase());
+		if (size > 0) {
+			WriteOut(pbase(), size);
+			setp(m_buffer, m_buffer + sizeof(m_buffer) - 1);
+		}
+	}
+
+	bool AtLineStart( void ) const {
+		return m_last == '\n';
+	}
+};
+
+static OutputWriter &Writer( void ) {
+	static OutputWriter writer;
+	return writer;
+}
+
+std::ostream &cc0::utest::Log( void )
+{
+	static std::ostream out(&Writer());
+	return out;
+}
+
+void cc0::utest::SetOutputStream(std::FILE *stream)
+{
+	Writer().SetStream(stream);
+}
+
+std::ostream &cc0::utest::BeginReport( void )
+{
+	// JSONL consumers expect every line to parse as one object, so diagnostics are dropped rather than injected into the stream; muted probe replays drop theirs the same way.
+	static std::ostream discard(nullptr);
+	if (g_mute_reports) {
+		return discard;
+	}
+	if (g_format == cc0::utest::OUTPUT_CONSOLE) {
+		return Log() << "\n    ";
+	}
+	if (g_format == cc0::utest::OUTPUT_TAP) {
+		return Log() << "# ";
+	}
+	return discard;
+}
+
+void cc0::utest::EndReport(std::ostream &out)
+{
+	if (g_format == cc0::utest::OUTPUT_TAP) {
+		// Terminate the comment line so the next result record starts at column 0, and hand it to the destination whole like EmitStructuredResult does.
+		out << "\n";
+		out.flush();
+	}
+}
+
+static const uint32_t NO_CONTEXT = uint32_t(-1);
+
+/// @brief Computes the 64-bit FNV-1a hash of a NUL-terminated string.
+static uint64_t HashString(const char *s)
+{
+	uint64_t h = 14695981039346656037ull;
+	while (*s != 0) {
+		h = (h ^ uint64_t(uint8_t(*s))) * 1099511628211ull;
+		++s;
+	}
+	return h;
+}
+
+/// @brief Continues an FNV-1a hash over another NUL-terminated string, combining the two into one stable hash.
+static uint64_t HashCombineString(uint64_t h, const char *s)
+{
+	while (*s != 0) {
+		h = (h ^ uint64_t(uint8_t(*s))) * 1099511628211ull;
+		++s;
+	}
+	return h;
+}
+
+static bool g_update_golden = false;
+
+/// @brief One golden baseline file held open for the duration of the run: memory-mapped on POSIX platforms, loaded onto the heap elsewhere. Failures to read are cached too so a missing baseline is not retried by every test that names it.
+struct GoldenMapping
+{
+	uint64_t       path_hash;
+	const uint8_t *data;
+	uint64_t       size;
+	bool           valid;
+};
+
+static std::mutex g_golden_lock;
+
+/// @brief Returns the baseline mappings acquired so far this run.
+static Array<GoldenMapping> &GoldenCache( void )
+{
+	static Array<GoldenMapping> cache;
+	return cache;
+}
+
+/// @brief Unmaps (or frees) every cached baseline. Called once the run has finished; entries are never released mid-run so a mapping handed to one thread stays valid while another acquires.
+static void ReleaseGoldenCache( void )
+{
+	std::lock_guard<std::mutex> lock(g_golden_lock);
+	Array<GoldenMapping> &cache = GoldenCache();
+	for (uint32_t i = 0; i < cache.Size(); ++i) {
+		if (cache[i].data != nullptr) {
+#if defined(CC0_UTEST_POSIX)
+			munmap(const_cast<uint8_t*>(cache[i].data), size_t(cache[i].size));
+#else
+			delete [] cache[i].data;
+#endif
+		}
+	}
+	cache = Array<GoldenMapping>();
+}
+
+/// @brief Returns the cached mapping of a baseline file, opening and mapping it on first use. The comparison itself never copies the file: on POSIX the kernel pages the baseline in directly behind the mapping.
+static GoldenMapping AcquireGolden(const char *path)
+{
+	const uint64_t hash = HashString(path);
+	std::lock_guard<std::mutex> lock(g_golden_lock);
+	Array<GoldenMapping> &cache = GoldenCache();
+	for (uint32_t i = 0; i < cache.Size(); ++i) {
+		if (cache[i].path_hash == hash) {
+			return cache[i];
+		}
+	}
+	GoldenMapping m;
+	m.path_hash = hash;
+	m.data = nullptr;
+	m.size = 0;
+	m.valid = false;
+#if defined(CC0_UTEST_POSIX)
+	const int fd = open(path, O_RDONLY);
+	if (fd >= 0) {
+		struct stat st;
+		if (fstat(fd, &st) == 0) {
+			m.size = uint64_t(st.st_size);
+			if (m.size == 0) {
+				// Mapping zero bytes is an error, but an empty baseline is a valid one.
+				m.valid = true;
+			} else {
+				void *p = mmap(nullptr, size_t(m.size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED) {
+					m.data = static_cast<const uint8_t*>(p);
+					m.valid = true;
+				} else {
+					m.size = 0;
+				}
+			}
+		}
+		close(fd);
+	}
+#else
+	std::FILE *f = std::fopen(path, "rb");
+	if (f != nullptr) {
+		if (std::fseek(f, 0, SEEK_END) == 0) {
+			const long end = std::ftell(f);
+			if (end >= 0 && std::fseek(f, 0, SEEK_SET) == 0) {
+				m.size = uint64_t(end);
+				uint8_t *buffer = m.size > 0 ? new uint8_t[m.size] : nullptr;
+				if (m.size == 0 || std::fread(buffer, 1, size_t(m.size), f) == size_t(m.size)) {
+					m.data = buffer;
+					m.valid = true;
+				} else {
+					delete [] buffer;
+					m.size = 0;
+				}
+			}
+		}
+		std::fclose(f);
+	}
+#endif
+	cache.Add(m);
+	return m;
+}
+
+/// @brief Rewrites a baseline file from the buffer under test. On POSIX the bytes are written through a shared mapping of the grown file rather than the write path.
+static bool WriteGolden(const char *path, const void *data, uint64_t size)
+{
+#if defined(CC0_UTEST_POSIX)
+	const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	bool written = size == 0;
+	if (size > 0 && ftruncate(fd, off_t(size)) == 0) {
+		void *p = mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED) {
+			std::memcpy(p, data, size_t(size));
+			munmap(p, size_t(size));
+			written = true;
+		}
+	}
+	close(fd);
+	return written;
+#else
+	std::FILE *f = std::fopen(path, "wb");
+	if (f == nullptr) {
+		return false;
+	}
+	const bool written = size == 0 || std::fwrite(data, 1, size_t(size), f) == size_t(size);
+	std::fclose(f);
+	return written;
+#endif
+}
+
+/// @brief Prints up to 16 bytes of one side of a failed golden comparison as hex, marking the mismatching offset.
+static void PrintHexWindow(const char *label, const uint8_t *data, uint64_t size, uint64_t offset)
+{
+	static const char digits[] = "0123456789abcdef";
+	const uint64_t from = offset > 8 ? offset - 8 : 0;
+	uint64_t to = from + 16;
+	if (to > size) {
+		to = size;
+	}
+	std::ostream &out = cc0::utest::BeginReport();
+	out << "  " << label << " [" << from << ".." << to << "):";
+	for (uint64_t i = from; i < to; ++i) {
+		out << (i == offset ? '>' : ' ') << digits[data[i] >> 4] << digits[data[i] & 15];
+	}
+	if (offset >= size) {
+		out << " >(end)";
+	}
+	cc0::utest::EndReport(out);
+}
+
+/// @brief Formats and emits the diagnostic of a failed golden comparison: the sizes when they differ, the first mismatching offset, and a hex window of both sides around it.
+static void ReportGoldenFailure(uint64_t assert_count, int line, const char *path, const GoldenMapping &golden, const uint8_t *data, uint64_t size)
+{
+	const uint64_t common = golden.size < size ? golden.size : size;
+	uint64_t offset = 0;
+	while (offset < common && golden.data[offset] == data[offset]) {
+		++offset;
+	}
+	std::ostream &out = cc0::utest::BeginReport();
+	out << "#" << assert_count << " @" << line << ": differs from golden \"" << path << "\"";
+	if (golden.size != size) {
+		out << " (baseline " << golden.size << " bytes, buffer " << size << " bytes)";
+	}
+	out << " at offset " << offset;
+	cc0::utest::EndReport(out);
+	PrintHexWindow("golden", golden.data, golden.size, offset);
+	PrintHexWindow("buffer", data, size, offset);
+}
+
+bool cc0::utest::UTestBase::AssertGolden(const char *path, const void *data, uint64_t size, int line)
+{
+	IncrementAssertCount();
+	if (g_update_golden) {
+		if (!WriteGolden(path, data, size)) {
+			Fail();
+			std::ostream &out = cc0::utest::BeginReport();
+			out << "#" << AssertCount() << " @" << line << ": golden baseline \"" << path << "\" cannot be written";
+			cc0::utest::EndReport(out);
+			return false;
+		}
+		return true;
+	}
+	const GoldenMapping golden = AcquireGolden(path);
+	if (!golden.valid) {
+		Fail();
+		std::ostream &out = cc0::utest::BeginReport();
+		out << "#" << AssertCount() << " @" << line << ": golden baseline \"" << path << "\" cannot be read (run with update_golden to create it)";
+		cc0::utest::EndReport(out);
+		return false;
+	}
+	// One wide library comparison decides the assertion; the mismatching offset is only located by rescanning once it has already failed.
+	if (golden.size == size && (size == 0 || std::memcmp(golden.data, data, size_t(size)) == 0)) {
+		return true;
+	}
+	Fail();
+	ReportGoldenFailure(AssertCount(), line, path, golden, static_cast<const uint8_t*>(data), size);
+	return false;
+}
+
+struct ContextItem
+{
+	const char      *name;  // Points at the string literal handed over by the registration macro; never owned or copied.
+	uint64_t        hash;
+	bool            (*init)();
+	bool            (*cleanup)();
+	Array<TestItem> tests;
+	uint32_t        align_chars;
+
+	ContextItem(const char *context_name, uint64_t context_hash) : name(context_name), hash(context_hash), init(nullptr), cleanup(nullptr), align_chars(0) {}
+	ContextItem(ContextItem &&other) = default;
+	ContextItem &operator=(ContextItem &&other) = default;
+};
+
+/// @brief An open-addressing hash table with linear probing mapping context name hashes to indices into the context array. Keys are hashed once at registration so lookups do no string traversal unless hashes collide.
+class ContextIndex
+{
+private:
+	struct Slot
+	{
+		uint64_t hash;
+		uint32_t index;
+	};
+
+	Slot     *m_slots;
+	uint32_t  m_capacity;
+	uint32_t  m_used;
+
+	static uint32_t Probe(const Slot *slots, uint32_t capacity, uint64_t hash) {
+		uint32_t i = uint32_t(hash) & (capacity - 1);
+		while (slots[i].index != NO_CONTEXT) {
+			i = (i + 1) & (capacity - 1);
+		}
+		return i;
+	}
+
+	void Grow( void ) {
+		const uint32_t new_capacity = m_capacity > 0 ? m_capacity * 2 : 64;
+		Slot *new_slots = new Slot[new_capacity];
+		for (uint32_t i = 0; i < new_capacity; ++i) {
+			new_slots[i].index = NO_CONTEXT;
+		}
+		for (uint32_t i = 0; i < m_capacity; ++i) {
+			if (m_slots[i].index != NO_CONTEXT) {
+				new_slots[Probe(new_slots, new_capacity, m_slots[i].hash)] = m_slots[i];
+			}
+		}
+		delete [] m_slots;
+		m_slots = new_slots;
+		m_capacity = new_capacity;
+	}
+
+public:
+	ContextIndex( void ) : m_slots(nullptr), m_capacity(0), m_used(0) {}
+	~ContextIndex( void ) { delete [] m_slots; }
+
+	uint32_t Find(uint64_t hash, const char *name, const Array<ContextItem> &list) const {
+		if (m_capacity == 0) {
+			return NO_CONTEXT;
+		}
+		uint32_t i = uint32_t(hash) & (m_capacity - 1);
+		while (m_slots[i].index != NO_CONTEXT) {
+			if (m_slots[i].hash == hash && std::strcmp(list[m_slots[i].index].name, name) == 0) {
+				return m_slots[i].index;
+			}
+			i = (i + 1) & (m_capacity - 1);
+		}
+		return NO_CONTEXT;
+	}
+
+	void Insert(uint64_t hash, uint32_t index) {
+		if (m_used * 10 >= m_capacity * 7) {
+			Grow();
+		}
+		const uint32_t i = Probe(m_slots, m_capacity, hash);
+		m_slots[i].hash = hash;
+		m_slots[i].index = index;
+		++m_used;
+	}
+
+	void Rebuild(const Array<ContextItem> &list) {
+		for (uint32_t i = 0; i < m_capacity; ++i) {
+			m_slots[i].index = NO_CONTEXT;
+		}
+		m_used = 0;
+		for (uint32_t i = 0; i < list.Size(); ++i) {
+			Insert(list[i].hash, i);
+		}
+	}
+};
+
+struct ContextList
+{
+	Array<ContextItem> list;
+	ContextIndex       index;
+};
+
+static ContextList &Contexts( void ) {
+	static ContextList tests;
+	return tests;
+}
+
+static uint32_t FindContext(const char *name)
+{
+	ContextList &contexts = Contexts();
+	return contexts.index.Find(HashString(name), name, contexts.list);
+}
+
+static uint32_t FindOrAddContext(const char *name, uint64_t hash)
+{
+	ContextList &contexts = Contexts();
+	uint32_t c = contexts.index.Find(hash, name, contexts.list);
+	if (c == NO_CONTEXT) {
+		contexts.list.Add(ContextItem(name, hash));
+		c = contexts.list.Size() - 1;
+		contexts.index.Insert(hash, c);
+	}
+	return c;
+}
+
+/// @brief Returns whether the active run selected any test in the context. Contexts with no selected test are skipped entirely, including their init and cleanup.
+static bool ContextEnabled(const ContextItem &c)
+{
+	for (uint32_t i = 0; i < c.tests.Size(); ++i) {
+		if (c.tests[i].enabled) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/// @brief Re-enables every registered test once a sharded or filtered run has finished.
+static void RestoreEnabled( void )
+{
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			ci.tests[i].enabled = true;
+		}
+	}
+}
+
+/// @brief The state behind the self-updating progress line. Completions from concurrent workers land in atomics; whichever worker crosses the redraw interval repaints the line, so the throttle needs no dedicated thread.
+struct ProgressState
+{
+	std::atomic<uint32_t> done;
+	std::atomic<uint32_t> failed;
+	std::atomic<uint64_t> consumed_ns; // Expected cost of the tests completed so far, in the same currency as expected_ns.
+	std::atomic<uint64_t> last_draw_ns;
+	uint32_t              total;
+	uint64_t              expected_ns; // Expected cost of the whole selection, from recorded durations where known.
+	uint64_t              average_ns;  // Fallback cost of a test without a recorded duration.
+	uint64_t              start_ns;
+	bool                  active;
+};
+
+static ProgressState g_progress = { {0}, {0}, {0}, {0}, 0, 0, 0, 0, false };
+
+/// @brief Returns the expected cost of a test: its recorded duration when the loaded cache holds one, otherwise the average recorded duration of the selection.
+static uint64_t ExpectedCost(const TestItem &test)
+{
+	if (g_active_cache != nullptr) {
+		const CacheRecord *rec = g_active_cache->Find(test.key);
+		if (rec != nullptr && rec->wall_ns > 0) {
+			return rec->wall_ns;
+		}
+	}
+	return g_progress.average_ns;
+}
+
+/// @brief Repaints the progress line in place on standard error: done/total, failures, and the ETA from the expected cost still outstanding scaled by the observed pace so far.
+static void DrawProgress(uint64_t now_ns)
+{
+	const uint32_t done = g_progress.done.load(std::memory_order_relaxed);
+	const uint32_t failed = g_progress.failed.load(std::memory_order_relaxed);
+	const uint64_t consumed = g_progress.consumed_ns.load(std::memory_order_relaxed);
+	const uint64_t elapsed = now_ns - g_progress.start_ns;
+	const uint64_t remaining = g_progress.expected_ns > consumed ? g_progress.expected_ns - consumed : 0;
+	// Scale the outstanding expected cost by how the pace so far compares to the recorded durations.
+	const uint64_t eta_ns = consumed > 0 ? uint64_t(double(remaining) * (double(elapsed) / double(consumed))) : remaining;
+	const uint64_t eta_s = (eta_ns + 500000000ull) / 1000000000ull;
+	if (done < g_progress.total && g_progress.expected_ns > 0) {
+		std::fprintf(stderr, "\r\x1b[K[%u/%u] %u failed, eta %lum%02lus", done, g_progress.total, failed, (unsigned long)(eta_s / 60), (unsigned long)(eta_s % 60));
+	} else {
+		std::fprintf(stderr, "\r\x1b[K[%u/%u] %u failed", done, g_progress.total, failed);
+	}
+	std::fflush(stderr);
+}
+
+/// @brief Arms the progress line for the selected tests of this run: totals the selection, seeds the expected cost from the recorded durations of the loaded cache (tests without a record cost the average of those with one), and paints the first frame.
+static void ProgressInit( void )
+{
+	uint32_t total = 0;
+	uint32_t known = 0;
+	uint64_t known_ns = 0;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			if (!ci.tests[i].enabled) {
+				continue;
+			}
+			++total;
+			if (g_active_cache != nullptr) {
+				const CacheRecord *rec = g_active_cache->Find(ci.tests[i].key);
+				if (rec != nullptr && rec->wall_ns > 0) {
+					++known;
+					known_ns += rec->wall_ns;
+				}
+			}
+		}
+	}
+	g_progress.done = 0;
+	g_progress.failed = 0;
+	g_progress.consumed_ns = 0;
+	g_progress.last_draw_ns = 0;
+	g_progress.total = total;
+	g_progress.average_ns = known > 0 ? known_ns / known : 0;
+	g_progress.expected_ns = known_ns + uint64_t(total - known) * g_progress.average_ns;
+	g_progress.start_ns = WallNowNs();
+	g_progress.active = true;
+	DrawProgress(g_progress.start_ns);
+}
+
+/// @brief Counts one completed test toward the progress line and repaints it if the redraw interval has passed. Cheap enough to call from every runner; contended repaints are resolved by a compare-and-swap on the last redraw time.
+static void ProgressStep(const TestItem &test, bool passed)
+{
+	if (!g_progress.active) {
+		return;
+	}
+	g_progress.done.fetch_add(1, std::memory_order_relaxed);
+	if (!passed) {
+		g_progress.failed.fetch_add(1, std::memory_order_relaxed);
+	}
+	g_progress.consumed_ns.fetch_add(ExpectedCost(test), std::memory_order_relaxed);
+	const uint64_t now = WallNowNs();
+	uint64_t last = g_progress.last_draw_ns.load(std::memory_order_relaxed);
+	if (now - last < 250000000ull || !g_progress.last_draw_ns.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+		return;
+	}
+	DrawProgress(now);
+}
+
+/// @brief Ends the progress line with a final repaint and a newline so subsequent output starts on a fresh line.
+static void ProgressFinish( void )
+{
+	if (!g_progress.active) {
+		return;
+	}
+	DrawProgress(WallNowNs());
+	std::fprintf(stderr, "\n");
+	g_progress.active = false;
+}
+
+// The number of structured result lines emitted so far.
+static uint32_t g_emit_count = 0;
+
+/// @brief The distinct outcomes a structured result line can report.
+enum ResultKind
+{
+	RESULT_PASS,
+	RESULT_FAIL,
+	RESULT_TIMEOUT,
+	RESULT_CRASH,
+	RESULT_CACHED,
+	RESULT_RESUMED, // A pass replayed from the write-ahead journal of an earlier interrupted run.
+	RESULT_FLAKY    // A pass that needed one or more retries. Counts as passing, but reported distinctly so flaky tests stay visible.
+};
+
+/// @brief Writes a string as a JSON string literal, escaping quotes, backslashes and control characters.
+static void EmitJsonString(std::ostream &out, const char *s)
+{
+	out << "\"";
+	for (; *s != 0; ++s) {
+		const char c = *s;
+		if (c == '"' || c == '\\') {
+			out << "\\" << c;
+		} else if (uint8_t(c) < 0x20) {
+			const char *hex = "0123456789abcdef";
+			out << "\\u00" << hex[(uint8_t(c) >> 4)] << hex[uint8_t(c) & 0xf];
+		} else {
+			out << c;
+		}
+	}
+	out << "\"";
+}
+
+/// @brief Streams one structured result line for a finished test. Serialized with a lock so concurrent workers emit whole lines, and formatted straight into the reusable output buffer.
+static void EmitStructuredResult(const ContextItem &context, const TestItem &test, ResultKind kind, int32_t variant = -1)
+{
+	static std::mutex emit_lock;
+	static const char *kind_names[] = { "pass", "fail", "timeout", "crash", "cached", "resumed", "flaky" };
+
+	std::lock_guard<std::mutex> guard(emit_lock);
+	std::ostream &out = cc0::utest::Log();
+	if (g_format == cc0::utest::OUTPUT_TAP) {
+		out << (kind == RESULT_FAIL || kind == RESULT_TIMEOUT || kind == RESULT_CRASH ? "not ok " : "ok ") << ++g_emit_count << " - " << context.name << "::" << test.name;
+		if (variant >= 0) {
+			out << "[" << variant << "]";
+		}
+		if (kind != RESULT_PASS && kind != RESULT_FAIL) {
+			out << " # " << kind_names[kind];
+		}
+		out << "\n";
+	} else {
+		out << "{\"context\":";
+		EmitJsonString(out, context.name);
+		out << ",\"test\":";
+		EmitJsonString(out, test.name);
+		if (variant >= 0) {
+			out << ",\"variant\":" << variant;
+		}
+		out << ",\"status\":\"" << kind_names[kind] << "\",\"wall_ns\":" << test.wall_ns << ",\"cpu_ns\":" << test.cpu_ns;
+		if (g_track_memory.load(std::memory_order_relaxed)) {
+			out << ",\"alloc_count\":" << test.alloc_count << ",\"peak_bytes\":" << test.peak_bytes << ",\"leaked_bytes\":" << test.leaked_bytes;
+		}
+		out << "}\n";
+		++g_emit_count;
+	}
+	out.flush();
+}
+
+/// @brief Streams the per-context summary line of the structured formats. TAP has no context concept, so only JSONL emits one.
+static void EmitStructuredContext(const ContextItem &context, bool passed, uint64_t total_ns)
+{
+	if (g_format != cc0::utest::OUTPUT_JSONL) {
+		return;
+	}
+	std::ostream &out = cc0::utest::Log();
+	out << "{\"context\":";
+	EmitJsonString(out, context.name);
+	out << ",\"status\":\"" << (passed ? "pass" : "fail") << "\",\"wall_ns\":" << total_ns << "}\n";
+	out.flush();
+}
+
+/// @brief Ends a TAP stream with its trailing plan line covering every emitted result.
+static void EmitStructuredFooter( void )
+{
+	if (g_format == cc0::utest::OUTPUT_TAP) {
+		std::ostream &out = cc0::utest::Log();
+		out << "1.." << g_emit_count << "\n";
+		out.flush();
+	}
+}
+
+static bool g_trace_active = false;
+static uint64_t g_trace_origin = 0; // The wall clock at run start; trace timestamps are relative to it so they stay small.
+
+/// @brief One span of the run profile: a test, a fixture function, or the run itself. Name and context point at the registration string literals, so buffering an event costs two pointers and three integers.
+struct TraceSpan
+{
+	const char *name;
+	const char *context; // Null for the run-level span.
+	const char *category;
+	uint64_t    begin_ns;
+	uint64_t    dur_ns;
+	uint32_t    tid;
+};
+
+static std::mutex g_trace_lock;
+
+/// @brief Returns the buffered profile spans of the active run.
+static Array<TraceSpan> &TraceBuffer( void )
+{
+	static Array<TraceSpan> buffer;
+	return buffer;
+}
+
+/// @brief Returns a small stable integer identifying the calling thread, assigned on first use. The trace format wants numeric thread ids and std::thread::id offers no portable conversion.
+static uint32_t TraceTid( void )
+{
+	static std::atomic<uint32_t> next(1);
+	thread_local uint32_t tid = 0;
+	if (tid == 0) {
+		tid = next.fetch_add(1);
+	}
+	return tid;
+}
+
+/// @brief Buffers one profile span. Nothing is written until the run is over, so profiling does not perturb the timings it records beyond an appended struct per span.
+static void TraceAdd(const char *context, const char *name, const char *category, uint64_t begin_ns, uint64_t dur_ns)
+{
+	TraceSpan span;
+	span.name = name;
+	span.context = context;
+	span.category = category;
+	span.begin_ns = begin_ns;
+	span.dur_ns = dur_ns;
+	span.tid = TraceTid();
+	std::lock_guard<std::mutex> lock(g_trace_lock);
+	TraceBuffer().Add(span);
+}
+
+/// @brief Buffers the span of a test that just finished, derived from its recorded wall duration.
+static void TraceTest(const char *context, const TestItem &test)
+{
+	if (!g_trace_active) {
+		return;
+	}
+	const uint64_t end = WallNowNs();
+	TraceAdd(context, test.name, "test", end - (test.wall_ns < end ? test.wall_ns : end), test.wall_ns);
+}
+
+/// @brief Buffers the span of a context init or cleanup function that began at the given wall clock and finishes now.
+static void TraceFixture(const char *context, const char *name, uint64_t begin_ns)
+{
+	if (!g_trace_active) {
+		return;
+	}
+	TraceAdd(context, name, "fixture", begin_ns, WallNowNs() - begin_ns);
+}
+
+/// @brief Writes a string as a JSON string literal to a file, escaping the same set EmitJsonString does.
+static void FputJsonString(std::FILE *f, const char *s)
+{
+	std::fputc('"', f);
+	for (; *s != 0; ++s) {
+		const char c = *s;
+		if (c == '"' || c == '\\') {
+			std::fputc('\\', f);
+			std::fputc(c, f);
+		} else if (uint8_t(c) < 0x20) {
+			std::fprintf(f, "\\u%04x", unsigned(uint8_t(c)));
+		} else {
+			std::fputc(c, f);
+		}
+	}
+	std::fputc('"', f);
+}
+
+/// @brief Writes every buffered profile span as Chrome trace-event JSON (complete events, microsecond timestamps relative to run start). The file loads directly into chrome://tracing or Perfetto and renders the suite as a flamegraph; gaps between spans on a thread are scheduler and reporting overhead.
+static void WriteTrace(const char *path)
+{
+	std::FILE *f = std::fopen(path, "w");
+	if (f == nullptr) {
+		return;
+	}
+	std::fputs("{\"traceEvents\":[", f);
+	Array<TraceSpan> &spans = TraceBuffer();
+	for (uint32_t i = 0; i < spans.Size(); ++i) {
+		const TraceSpan &s = spans[i];
+		const uint64_t ts = s.begin_ns > g_trace_origin ? s.begin_ns - g_trace_origin : 0;
+		std::fputs(i > 0 ? ",\n" : "\n", f);
+		std::fputs("{\"name\":", f);
+		FputJsonString(f, s.name);
+		std::fprintf(f, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":1,\"tid\":%u", s.category, (unsigned long long)(ts / 1000), unsigned(ts % 1000), (unsigned long long)(s.dur_ns / 1000), unsigned(s.dur_ns % 1000), s.tid);
+		if (s.context != nullptr) {
+			std::fputs(",\"args\":{\"context\":", f);
+			FputJsonString(f, s.context);
+			std::fputs("}", f);
+		}
+		std::fputs("}", f);
+	}
+	std::fputs("\n]}\n", f);
+	std::fclose(f);
+}
+
+static void PrintTestName(const char *class_name, uint32_t name_len, uint32_t align_chars)
+{
+	std::ostream &out = cc0::utest::Log();
+	out << "  ";
+	for (uint32_t i = 0; i < name_len; ++i) {
+		out << (class_name[i] == '_' ? ' ' : class_name[i]);
+	}
+	out << " \x8";
+	for (uint32_t i = 0; i < align_chars - name_len; ++i) {
+		out << ".";
+	}
+}
+
+/// @brief Prints one variant row name of a parameterized test: the class name, the variant index in brackets, and dots padding out to the aligned result column of the context.
+static void PrintParamTestName(const char *class_name, uint32_t name_len, uint32_t variant, uint32_t align_chars)
+{
+	std::ostream &out = cc0::utest::Log();
+	out << "  ";
+	for (uint32_t i = 0; i < name_len; ++i) {
+		out << (class_name[i] == '_' ? ' ' : class_name[i]);
+	}
+	out << "[" << variant << "]";
+	uint32_t printed = name_len + 2;
+	for (uint32_t v = variant; ; v /= 10) {
+		++printed;
+		if (v < 10) {
+			break;
+		}
+	}
+	out << " \x8";
+	for (uint32_t i = printed; i < align_chars; ++i) {
+		out << ".";
+	}
+}
+
+/// @brief Checks whether the active journal holds an outcome for the test from an earlier interrupted run, restoring the recorded result onto the test if so. A started record without an outcome means the earlier run died inside the test, reported as a crash.
+static bool JournaledResult(TestItem &test, ResultKind &kind)
+{
+	if (g_active_journal == nullptr) {
+		return false;
+	}
+	const JournalRecord *rec = g_active_journal->Find(test.key);
+	if (rec == nullptr) {
+		return false;
+	}
+	test.wall_ns = rec->wall_ns;
+	test.cpu_ns = rec->cpu_ns;
+	test.last_result = rec->status == JOURNAL_PASSED ? 1 : 0;
+	kind = rec->status == JOURNAL_PASSED ? RESULT_RESUMED : (rec->status == JOURNAL_FAILED ? RESULT_FAIL : RESULT_CRASH);
+	return true;
+}
+
+/// @brief Returns whether the active journal holds any record for the test.
+static bool Journaled(const TestItem &test)
+{
+	return g_active_journal != nullptr && g_active_journal->Find(test.key) != nullptr;
+}
+
+/// @brief One asynchronous test in flight on the event loop.
+struct AsyncFlight
+{
+	TestItem *test;
+	void     *obj;
+	bool      pending;
+};
+
+/// @brief Drives every selected asynchronous test of the context concurrently on the calling thread, round-robining Step slices across the tests still pending so a wait in one test overlaps with progress in the others. Results and accumulated slice durations land on the tests; the reporting pass afterwards prints them in registration order.
+static void RunAsyncTests(ContextItem &c)
+{
+	if (StopRequested()) {
+		return;
+	}
+	uint32_t flight_count = 0;
+	for (uint32_t i = 0; i < c.tests.Size(); ++i) {
+		if (c.tests[i].enabled && c.tests[i].async != nullptr && !Journaled(c.tests[i]) && !CachedPass(c.tests[i])) {
+			++flight_count;
+		}
+	}
+	if (flight_count == 0) {
+		return;
+	}
+	AsyncFlight *flights = new AsyncFlight[flight_count];
+	uint32_t f = 0;
+	for (uint32_t i = 0; i < c.tests.Size(); ++i) {
+		TestItem &t = c.tests[i];
+		if (t.enabled && t.async != nullptr && !Journaled(t) && !CachedPass(t)) {
+			flights[f].test = &t;
+			flights[f].obj = t.async->create();
+			flights[f].pending = true;
+			t.wall_ns = 0;
+			t.cpu_ns = 0;
+			JournalStart(t);
+			++f;
+		}
+	}
+	uint32_t pending_count = flight_count;
+	while (pending_count > 0) {
+		for (f = 0; f < flight_count; ++f) {
+			if (!flights[f].pending) {
+				continue;
+			}
+			TestItem &t = *flights[f].test;
+			const uint64_t wall = WallNowNs();
+			const uint64_t cpu = CpuNowNs();
+			const bool more = t.async->step(flights[f].obj);
+			t.cpu_ns += CpuNowNs() - cpu;
+			t.wall_ns += WallNowNs() - wall;
+			if (!more) {
+				flights[f].pending = false;
+				--pending_count;
+				t.last_result = t.async->succeeded(flights[f].obj) ? 1 : 0;
+				if (t.last_result == 0) {
+					CountFailure();
+				}
+				JournalFinish(t, t.last_result == 1);
+				ProgressStep(t, t.last_result == 1);
+				TraceTest(c.name, t);
+				t.async->destroy(flights[f].obj);
+			}
+		}
+	}
+	delete [] flights;
+}
+
+/// @brief Prints the memory counter deltas of a test next to its result. Prints nothing unless the run tracks memory.
+static void PrintMemCounters(std::ostream &out, const TestItem &test)
+{
+	if (!g_track_memory.load(std::memory_order_relaxed)) {
+		return;
+	}
+	out << " (allocs " << test.alloc_count << ", peak " << test.peak_bytes << " B, leaked " << test.leaked_bytes << " B)";
+}
+
+// The body and table entry the trampoline below hands to the variant of a parameterized test currently running. Only the serial runner expands variants, so one in-flight variant at a time is guaranteed and plain statics suffice even when the guarded call runs the trampoline on an executor thread.
+static bool (*g_param_run_one)(const void *param) = nullptr;
+static const void *g_param_arg = nullptr;
+
+/// @brief Adapts one parameterized test variant to the plain test signature the guarded execution machinery runs.
+static bool ParamTrampoline( void )
+{
+	return g_param_run_one(g_param_arg);
+}
+
+/// @brief Expands a parameterized test into one result row per table entry, running each variant under the test's deadline. Durations and memory counters accumulate onto the registered test (peak bytes keep the maximum), and any failing variant fails the test. Each failing variant counts toward the failure cutoff of the run.
+static bool RunParamTest(ContextItem &c, TestItem &test)
+{
+	std::ostream &out = cc0::utest::Log();
+	const bool console = g_format == cc0::utest::OUTPUT_CONSOLE;
+	const cc0::utest::ParamTest &table = *test.param;
+	const char *entries = static_cast<const char*>(table.params);
+	bool all_passed = true;
+	bool any_flaky = false;
+	uint64_t wall = 0;
+	uint64_t cpu = 0;
+	uint64_t allocs = 0;
+	uint64_t peak = 0;
+	int64_t leaked = 0;
+	TestItem variant = test;
+	variant.test = ParamTrampoline;
+	g_param_run_one = table.run_one;
+	JournalStart(test);
+	for (uint32_t v = 0; v < table.count; ++v) {
+		g_param_arg = entries + uint64_t(v) * table.stride;
+		if (console) {
+			PrintParamTestName(test.name, test.name_len, v, c.align_chars);
+		}
+		bool timed_out = false;
+		bool flaky = false;
+		const bool passed = RunWithRetry(variant, timed_out, flaky);
+		if (flaky) {
+			any_flaky = true;
+		}
+		wall += variant.wall_ns;
+		cpu += variant.cpu_ns;
+		allocs += variant.alloc_count;
+		peak = peak > variant.peak_bytes ? peak : variant.peak_bytes;
+		leaked += variant.leaked_bytes;
+		if (!passed) {
+			all_passed = false;
+			CountFailure();
+			if (console) {
+				out << (timed_out ? "\n    fail (timeout)" : "\n    fail");
+				PrintMemCounters(out, variant);
+				out << "\n";
+			} else {
+				EmitStructuredResult(c, variant, timed_out ? RESULT_TIMEOUT : RESULT_FAIL, int32_t(v));
+			}
+		} else if (console) {
+			out << (flaky ? "\n    ok (flaky)" : "ok");
+			PrintMemCounters(out, variant);
+			out << "\n";
+		} else {
+			EmitStructuredResult(c, variant, flaky ? RESULT_FLAKY : RESULT_PASS, int32_t(v));
+		}
+		if (console) {
+			out.flush();
+		}
+	}
+	test.wall_ns = wall;
+	test.cpu_ns = cpu;
+	test.alloc_count = allocs;
+	test.peak_bytes = peak;
+	test.leaked_bytes = leaked;
+	test.last_result = all_passed ? 1 : 0;
+	test.last_flaky = any_flaky;
+	JournalFinish(test, all_passed);
+	ProgressStep(test, all_passed);
+	TraceTest(c.name, test);
+	return all_passed;
+}
+
+static bool RunTests(ContextItem &c)
+{
+	std::ostream &out = cc0::utest::Log();
+	Array<TestItem> &tests = c.tests;
+	const bool console = g_format == cc0::utest::OUTPUT_CONSOLE;
+	bool status = true;
+	RunAsyncTests(c);
+	for (uint32_t i = 0; i < tests.Size(); ++i) {
+		if (!tests[i].enabled) {
+			continue;
+		}
+		if (StopRequested()) {
+			break;
+		}
+		// A fresh parameterized test prints one row per variant instead of the single name header.
+		const bool expand_param = tests[i].param != nullptr && !Journaled(tests[i]) && !CachedPass(tests[i]);
+		if (console && !expand_param) {
+			PrintTestName(tests[i].name, tests[i].name_len, c.align_chars);
+		}
+		ResultKind journal_kind = RESULT_PASS;
+		if (JournaledResult(tests[i], journal_kind)) {
+			const bool journal_passed = journal_kind == RESULT_RESUMED;
+			ProgressStep(tests[i], journal_passed);
+			if (!journal_passed) {
+				status = false;
+				CountFailure();
+			}
+			if (console) {
+				out << (journal_passed ? "ok (resumed)\n" : journal_kind == RESULT_CRASH ? "\n    fail (crashed)\n" : "\n    fail (resumed)\n");
+				out.flush();
+			} else {
+				EmitStructuredResult(c, tests[i], journal_kind);
+			}
+			if (!journal_passed && tests[i].must_pass) {
+				if (console) {
+					out << "  [abort]\n";
+					out.flush();
+				}
+				break;
+			}
+			continue;
+		}
+		if (CachedPass(tests[i])) {
+			ProgressStep(tests[i], true);
+			if (console) {
+				out << "ok (cached)\n";
+				out.flush();
+			} else {
+				EmitStructuredResult(c, tests[i], RESULT_CACHED);
+			}
+			continue;
+		}
+		if (expand_param) {
+			if (!RunParamTest(c, tests[i])) {
+				status = false;
+				if (tests[i].must_pass) {
+					if (console) {
+						out << "  [abort]\n";
+						out.flush();
+					}
+					break;
+				}
+			}
+			continue;
+		}
+		bool timed_out = false;
+		bool flaky = false;
+		bool passed;
+		if (tests[i].async != nullptr) {
+			// Already driven to completion by the event loop above; failures were counted and journaled there.
+			passed = tests[i].last_result == 1;
+		} else {
+			JournalStart(tests[i]);
+			passed = RunWithRetry(tests[i], timed_out, flaky);
+			tests[i].last_flaky = flaky;
+			JournalFinish(tests[i], passed);
+			ProgressStep(tests[i], passed);
+			TraceTest(c.name, tests[i]);
+			if (!passed) {
+				CountFailure();
+			}
+		}
+		if (!passed) {
+			status = false;
+			if (console) {
+				out << (timed_out ? "\n    fail (timeout)" : "\n    fail");
+				PrintMemCounters(out, tests[i]);
+				out << "\n";
+			} else {
+				EmitStructuredResult(c, tests[i], timed_out ? RESULT_TIMEOUT : RESULT_FAIL);
+			}
+			if (tests[i].must_pass) {
+				if (console) {
+					out << "  [abort]\n";
+					out.flush();
+				}
+				break;
+			}
+		} else if (console) {
+			// A flaky pass has the diagnostics of its failed attempts inline above it, so the verdict starts a fresh line like fail does.
+			out << (flaky ? "\n    ok (flaky)" : "ok");
+			PrintMemCounters(out, tests[i]);
+			out << "\n";
+		} else {
+			EmitStructuredResult(c, tests[i], flaky ? RESULT_FLAKY : RESULT_PASS);
+		}
+		if (console) {
+			out.flush();
+		}
+	}
+	return status;
+}
+
+static bool RunContext(ContextItem *c)
+{
+	if (!ContextEnabled(*c)) {
+		return true;
+	}
+	std::ostream &out = cc0::utest::Log();
+	const bool console = g_format == cc0::utest::OUTPUT_CONSOLE;
+	bool status = true;
+	if (console) {
+		out << c->name << "\n";
+	}
+	bool init_ok = true;
+	if (c->init != nullptr) {
+		const uint64_t begin = WallNowNs();
+		init_ok = c->init();
+		TraceFixture(c->name, "init", begin);
+	}
+	if (!init_ok || !RunTests(*c)) {
+		status = false;
+	}
+	if (c->cleanup != nullptr) {
+		const uint64_t begin = WallNowNs();
+		const bool cleanup_ok = c->cleanup();
+		TraceFixture(c->name, "cleanup", begin);
+		if (!cleanup_ok) {
+			status = false;
+		}
+	}
+	uint64_t total_ns = 0;
+	for (uint32_t i = 0; i < c->tests.Size(); ++i) {
+		if (c->tests[i].enabled) {
+			total_ns += c->tests[i].wall_ns;
+		}
+	}
+	if (console) {
+		out << "  " << (status ? "[ok]" : "[fail]") << " (";
+		PrintMs(out, total_ns);
+		out << ")\n";
+		out.flush();
+	} else {
+		EmitStructuredContext(*c, status, total_ns);
+	}
+	return status;
+}
+
+/// @brief Shared per-context state while tests in the context execute on worker threads.
+struct JobContext
+{
+	ContextItem           *context;
+	std::once_flag         init_once;
+	bool                   init_ok;
+	std::atomic<bool>      init_ran;
+	std::atomic<bool>      aborted;
+	std::atomic<bool>      failed;
+	std::atomic<uint32_t>  tests_left;
+
+	explicit JobContext(ContextItem *c) : context(c), init_ok(true), init_ran(false), aborted(false), failed(false), tests_left(0) {}
+};
+
+/// @brief A single test invocation scheduled on the worker pool.
+struct Job
+{
+	JobContext *job_context;
+	TestItem   *test;
+	bool        ran;
+	bool        passed;
+	bool        crashed;
+	bool        timed_out;
+	bool        cached;
+	bool        resumed; // The result was replayed from the write-ahead journal of an earlier interrupted run.
+	bool        flaky;   // The pass needed one or more retries.
+};
+
+/// @brief A bounded deque of jobs owned by one worker. The owner takes jobs from the front while idle workers steal from the back.
+class JobQueue
+{
+private:
+	std::mutex   m_lock;
+	Job        **m_jobs;
+	uint32_t     m_first;
+	uint32_t     m_end;
+
+public:
+	JobQueue( void ) : m_jobs(nullptr), m_first(0), m_end(0) {}
+	~JobQueue( void ) { delete [] m_jobs; }
+
+	void Allocate(uint32_t capacity) {
+		m_jobs = new Job*[capacity];
+	}
+
+	void Push(Job *job) {
+		m_jobs[m_end++] = job;
+	}
+
+	Job *TakeFront( void ) {
+		std::lock_guard<std::mutex> guard(m_lock);
+		return m_first < m_end ? m_jobs[m_first++] : nullptr;
+	}
+
+	Job *TakeBack( void ) {
+		std::lock_guard<std::mutex> guard(m_lock);
+		return m_first < m_end ? m_jobs[--m_end] : nullptr;
+	}
+};
+
+/// @brief Runs the context init function exactly once across all workers touching the context.
+static void InitJobContext(JobContext *jc)
+{
+	std::call_once(
+		jc->init_once,
+		[jc]( void ) {
+			jc->init_ran = true;
+			if (jc->context->init != nullptr) {
+				const uint64_t begin = WallNowNs();
+				const bool ok = jc->context->init();
+				TraceFixture(jc->context->name, "init", begin);
+				if (!ok) {
+					jc->init_ok = false;
+					jc->failed = true;
+					jc->aborted = true;
+				}
+			}
+		}
+	);
+}
+
+/// @brief Executes a single scheduled test and runs the context cleanup function once the last test in the context finishes.
+static void ExecuteJob(Job *job)
+{
+	JobContext *jc = job->job_context;
+	ResultKind journal_kind = RESULT_PASS;
+	if (CachedPass(*job->test)) {
+		job->ran = true;
+		job->passed = true;
+		job->cached = true;
+	} else if (JournaledResult(*job->test, journal_kind)) {
+		job->ran = true;
+		job->resumed = true;
+		job->passed = journal_kind == RESULT_RESUMED;
+		job->crashed = journal_kind == RESULT_CRASH;
+		if (!job->passed) {
+			jc->failed = true;
+			CountFailure();
+			if (job->test->must_pass) {
+				jc->aborted = true;
+			}
+		}
+	} else if (!StopRequested()) {
+		InitJobContext(jc);
+		if (!jc->aborted) {
+			job->ran = true;
+			JournalStart(*job->test);
+			job->passed = RunWithRetry(*job->test, job->timed_out, job->flaky);
+			job->test->last_flaky = job->flaky;
+			JournalFinish(*job->test, job->passed);
+			TraceTest(jc->context->name, *job->test);
+			if (!job->passed) {
+				jc->failed = true;
+				CountFailure();
+				if (job->test->must_pass) {
+					jc->aborted = true;
+				}
+			}
+		}
+	}
+	if (job->ran) {
+		ProgressStep(*job->test, job->passed);
+	}
+	if (job->ran && g_format != cc0::utest::OUTPUT_CONSOLE) {
+		EmitStructuredResult(*jc->context, *job->test, job->cached ? RESULT_CACHED : job->passed ? (job->resumed ? RESULT_RESUMED : job->flaky ? RESULT_FLAKY : RESULT_PASS) : job->timed_out ? RESULT_TIMEOUT : job->crashed ? RESULT_CRASH : RESULT_FAIL);
+	}
+	if (--jc->tests_left == 0) {
+		if (jc->init_ran && jc->context->cleanup != nullptr) {
+			const uint64_t begin = WallNowNs();
+			const bool ok = jc->context->cleanup();
+			TraceFixture(jc->context->name, "cleanup", begin);
+			if (!ok) {
+				jc->failed = true;
+			}
+		}
+	}
+}
+
+/// @brief The worker loop. Drains the worker's own queue front-first, then steals from the back of the other workers' queues.
+static void WorkerLoop(JobQueue *queues, uint32_t queue_count, uint32_t self)
+{
+	while (true) {
+		Job *job = queues[self].TakeFront();
+		for (uint32_t i = 1; job == nullptr && i < queue_count; ++i) {
+			job = queues[(self + i) % queue_count].TakeBack();
+		}
+		if (job == nullptr) {
+			break;
+		}
+		ExecuteJob(job);
+	}
+}
+
+/// @brief Prints the recorded results of a completed parallel run in registration order, mirroring the serial output format. Contexts with no scheduled job are skipped.
+static bool PrintJobResults(Job *jobs, uint32_t job_count)
+{
+	std::ostream &out = cc0::utest::Log();
+	const bool console = g_format == cc0::utest::OUTPUT_CONSOLE;
+	// Worker diagnostics stream out as tests execute and leave no trailing newline, so the replay may otherwise start mid-line.
+	if (console && !Writer().AtLineStart()) {
+		out << "\n";
+	}
+	bool status = true;
+	uint32_t j = 0;
+	while (j < job_count) {
+		JobContext *jc = jobs[j].job_context;
+		if (console) {
+			out << jc->context->name << "\n";
+		}
+		uint64_t total_ns = 0;
+		bool aborted = false;
+		for (; j < job_count && jobs[j].job_context == jc; ++j) {
+			Job *job = &jobs[j];
+			if (!job->ran || aborted) {
+				continue;
+			}
+			total_ns += job->test->wall_ns;
+			if (!console) {
+				continue;
+			}
+			PrintTestName(job->test->name, job->test->name_len, jc->context->align_chars);
+			if (!job->passed) {
+				out << (job->timed_out ? "\n    fail (timeout)" : job->crashed ? "\n    fail (crashed)" : job->resumed ? "\n    fail (resumed)" : "\n    fail");
+				PrintMemCounters(out, *job->test);
+				out << "\n";
+				if (job->test->must_pass) {
+					out << "  [abort]\n";
+					aborted = true;
+				}
+			} else if (job->cached) {
+				out << "ok (cached)\n";
+			} else if (job->resumed) {
+				out << "ok (resumed)\n";
+			} else if (job->flaky) {
+				out << "ok (flaky)";
+				PrintMemCounters(out, *job->test);
+				out << "\n";
+			} else {
+				out << "ok";
+				PrintMemCounters(out, *job->test);
+				out << "\n";
+			}
+		}
+		if (jc->failed) {
+			status = false;
+		}
+		if (console) {
+			out << "  " << (jc->failed ? "[fail]" : "[ok]") << " (";
+			PrintMs(out, total_ns);
+			out << ")\n";
+			out.flush();
+		} else {
+			EmitStructuredContext(*jc->context, !jc->failed, total_ns);
+		}
+	}
+	return status;
+}
+
+/// @brief A flat snapshot of every registered test paired with the shared state of its context, built once per run.
+struct JobTable
+{
+	JobContext *job_contexts;
+	Job        *jobs;
+	uint32_t    context_count;
+	uint32_t    job_count;
+
+	JobTable( void ) : job_contexts(nullptr), jobs(nullptr), context_count(0), job_count(0) {
+		context_count = Contexts().list.Size();
+		for (uint32_t c = 0; c < context_count; ++c) {
+			const ContextItem &ci = Contexts().list[c];
+			for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+				if (ci.tests[i].enabled) {
+					++job_count;
+				}
+			}
+		}
+		if (job_count == 0) {
+			return;
+		}
+		job_contexts = static_cast<JobContext*>(::operator new(sizeof(JobContext) * context_count));
+		jobs = new Job[job_count];
+		uint32_t j = 0;
+		for (uint32_t c = 0; c < context_count; ++c) {
+			ContextItem &ci = Contexts().list[c];
+			JobContext *jc = new (job_contexts + c) JobContext(&ci);
+			for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+				if (!ci.tests[i].enabled) {
+					continue;
+				}
+				jobs[j].job_context = jc;
+				jobs[j].test        = &ci.tests[i];
+				jobs[j].ran         = false;
+				jobs[j].passed      = false;
+				jobs[j].crashed     = false;
+				jobs[j].timed_out   = false;
+				jobs[j].cached      = false;
+				jobs[j].resumed     = false;
+				jobs[j].flaky       = false;
+				++jc->tests_left;
+				++j;
+			}
+		}
+	}
+
+	~JobTable( void ) {
+		for (uint32_t i = 0; i < context_count && job_contexts != nullptr; ++i) {
+			job_contexts[i].~JobContext();
+		}
+		::operator delete(job_contexts);
+		delete [] jobs;
+	}
+};
+
+/// @brief Runs all registered tests on a pool of work-stealing worker threads.
+static bool RunParallel(uint32_t thread_count)
+{
+	JobTable table;
+	if (table.job_count == 0) {
+		return true;
+	}
+
+	JobQueue *queues = new JobQueue[thread_count];
+	for (uint32_t q = 0; q < thread_count; ++q) {
+		queues[q].Allocate(table.job_count);
+	}
+	for (uint32_t j = 0; j < table.job_count; ++j) {
+		queues[j % thread_count].Push(&table.jobs[j]);
+	}
+
+	std::thread *workers = new std::thread[thread_count];
+	for (uint32_t w = 0; w < thread_count; ++w) {
+		workers[w] = std::thread(WorkerLoop, queues, thread_count, w);
+	}
+	for (uint32_t w = 0; w < thread_count; ++w) {
+		workers[w].join();
+	}
+	delete [] workers;
+	delete [] queues;
+
+	return PrintJobResults(table.jobs, table.job_count);
+}
+
+#if defined(CC0_UTEST_POSIX)
+
+/// @brief Reads exactly the requested number of bytes from a pipe. Returns false on EOF or error.
+static bool ReadFull(int fd, void *out, size_t size)
+{
+	char *dst = static_cast<char*>(out);
+	while (size > 0) {
+		const ssize_t r = ::read(fd, dst, size);
+		if (r <= 0) {
+			return false;
+		}
+		dst += r;
+		size -= size_t(r);
+	}
+	return true;
+}
+
+/// @brief Writes exactly the requested number of bytes to a pipe. Returns false on error.
+static bool WriteFull(int fd, const void *in, size_t size)
+{
+	const char *src = static_cast<const char*>(in);
+	while (size > 0) {
+		const ssize_t w = ::write(fd, src, size);
+		if (w <= 0) {
+			return false;
+		}
+		src += w;
+		size -= size_t(w);
+	}
+	return true;
+}
+
+/// @brief The result record a worker process sends back for one dispatched test.
+struct IsolatedResult
+{
+	uint64_t wall_ns;
+	uint64_t cpu_ns;
+	uint64_t alloc_count;
+	uint64_t peak_bytes;
+	int64_t  leaked_bytes;
+	uint8_t  passed;
+};
+
+/// @brief The loop run inside a preforked worker process. Receives job indices over a pipe, runs the tests, and answers with a pass/fail byte. Context init runs lazily once per worker process and cleanup runs on orderly shutdown, since process state is not shared with the parent.
+static void IsolatedWorkerLoop(const JobTable &table, int in_fd, int out_fd)
+{
+	bool *inited = new bool[table.context_count];
+	bool *init_failed = new bool[table.context_count];
+	for (uint32_t c = 0; c < table.context_count; ++c) {
+		inited[c] = false;
+		init_failed[c] = false;
+	}
+	int32_t job_index = 0;
+	while (ReadFull(in_fd, &job_index, sizeof(job_index))) {
+		Job *job = &table.jobs[job_index];
+		const uint32_t c = uint32_t(job->job_context - table.job_contexts);
+		ContextItem *ci = job->job_context->context;
+		IsolatedResult result = { 0, 0, 0, 0, 0, 0 };
+		if (!inited[c]) {
+			inited[c] = true;
+			init_failed[c] = ci->init != nullptr && !ci->init();
+		}
+		if (init_failed[c]) {
+			// No test of this context may run against the uninitialized fixture; every one dispatched here fails without executing, matching the serial runner skipping the context.
+			cc0::utest::Log().flush();
+			if (!WriteFull(out_fd, &result, sizeof(result))) {
+				break;
+			}
+			continue;
+		}
+		// The retry loop runs inside the worker so a retried test keeps its isolation; 2 marks a pass that needed a retry.
+		bool passed = TimedCall(*job->test);
+		bool flaky = false;
+		for (uint32_t attempt = 0; !passed && attempt < g_retry_count; ++attempt) {
+			RetryBackoff(attempt);
+			passed = TimedCall(*job->test);
+			if (passed) {
+				flaky = true;
+			}
+		}
+		result.passed = passed ? (flaky ? 2 : 1) : 0;
+		result.wall_ns = job->test->wall_ns;
+		result.cpu_ns = job->test->cpu_ns;
+		result.alloc_count = job->test->alloc_count;
+		result.peak_bytes = job->test->peak_bytes;
+		result.leaked_bytes = job->test->leaked_bytes;
+		// Console diagnostics of the test leave the stream mid-line; terminate them here so the output of the next worker, and the replay in the parent, starts at column 0.
+		if (!Writer().AtLineStart()) {
+			cc0::utest::Log() << "\n";
+		}
+		cc0::utest::Log().flush();
+		if (!WriteFull(out_fd, &result, sizeof(result))) {
+			break;
+		}
+	}
+	for (uint32_t c = 0; c < table.context_count; ++c) {
+		if (inited[c] && table.job_contexts[c].context->cleanup != nullptr) {
+			table.job_contexts[c].context->cleanup();
+		}
+	}
+	cc0::utest::Log().flush();
+	delete [] init_failed;
+	delete [] inited;
+	_exit(0);
+}
+
+/// @brief Records the outcome of a dispatched job in the parent, applies the must-pass abort semantics of its context, and streams the result in structured modes.
+static void RecordIsolatedResult(Job *job, ResultKind kind)
+{
+	job->ran = true;
+	job->passed = kind == RESULT_PASS || kind == RESULT_FLAKY || kind == RESULT_CACHED || kind == RESULT_RESUMED;
+	job->crashed = kind == RESULT_CRASH;
+	job->timed_out = kind == RESULT_TIMEOUT;
+	job->cached = kind == RESULT_CACHED;
+	job->flaky = kind == RESULT_FLAKY;
+	if (kind != RESULT_CACHED) {
+		job->test->last_result = job->passed ? 1 : 0;
+		job->test->last_flaky = job->flaky;
+	}
+	if (!job->passed) {
+		job->job_context->failed = true;
+		CountFailure();
+		if (job->test->must_pass) {
+			job->job_context->aborted = true;
+		}
+	}
+	ProgressStep(*job->test, job->passed);
+	if (kind != RESULT_CACHED && kind != RESULT_RESUMED) {
+		// The child reported its measured duration with the result; cached and replayed outcomes did not execute, so they have no span.
+		TraceTest(job->job_context->context->name, *job->test);
+	}
+	if (g_format != cc0::utest::OUTPUT_CONSOLE) {
+		EmitStructuredResult(*job->job_context->context, *job->test, kind);
+	}
+}
+
+/// @brief One preforked worker process as seen from the parent.
+struct WorkerProc
+{
+	pid_t    pid;
+	int      to_fd;       // Parent writes job indices here.
+	int      from_fd;     // Parent reads result bytes here.
+	int32_t  job;         // The job currently dispatched, or -1 when idle.
+	uint64_t deadline_ns; // Absolute wall-clock deadline of the dispatched job, or 0 when none applies.
+	bool     timed_out;   // Set when the parent killed the worker for exceeding its deadline.
+};
+
+/// @brief Forks one worker process inheriting the job table. Returns false if the fork failed.
+static bool SpawnWorker(const JobTable &table, WorkerProc &worker)
+{
+	int to_pipe[2];
+	int from_pipe[2];
+	if (pipe(to_pipe) != 0) {
+		return false;
+	}
+	if (pipe(from_pipe) != 0) {
+		::close(to_pipe[0]);
+		::close(to_pipe[1]);
+		return false;
+	}
+	const pid_t pid = fork();
+	if (pid < 0) {
+		::close(to_pipe[0]);
+		::close(to_pipe[1]);
+		::close(from_pipe[0]);
+		::close(from_pipe[1]);
+		return false;
+	}
+	if (pid == 0) {
+		::close(to_pipe[1]);
+		::close(from_pipe[0]);
+		IsolatedWorkerLoop(table, to_pipe[0], from_pipe[1]);
+	}
+	::close(to_pipe[0]);
+	::close(from_pipe[1]);
+	worker.pid = pid;
+	worker.to_fd = to_pipe[1];
+	worker.from_fd = from_pipe[0];
+	worker.job = -1;
+	worker.deadline_ns = 0;
+	worker.timed_out = false;
+	return true;
+}
+
+/// @brief Sends a job to a worker and arms the worker's deadline. Records a crash and returns false if the worker could not accept the job.
+static bool DispatchIsolatedJob(WorkerProc &worker, const JobTable &table, int32_t job)
+{
+	worker.job = job;
+	worker.timed_out = false;
+	const uint32_t timeout_ms = EffectiveTimeoutMs(*table.jobs[job].test);
+	worker.deadline_ns = timeout_ms > 0 ? WallNowNs() + uint64_t(timeout_ms) * 1000000ull : 0;
+	JournalStart(*table.jobs[job].test);
+	if (!WriteFull(worker.to_fd, &job, sizeof(job))) {
+		RecordIsolatedResult(&table.jobs[job], RESULT_CRASH);
+		worker.job = -1;
+		return false;
+	}
+	return true;
+}
+
+/// @brief Returns the next job not yet dispatched whose context has not been aborted, marking skipped jobs as not run. Returns -1 when the table is exhausted.
+static int32_t NextIsolatedJob(const JobTable &table, uint32_t &next)
+{
+	while (next < table.job_count) {
+		if (StopRequested()) {
+			return -1;
+		}
+		Job *job = &table.jobs[next];
+		if (job->job_context->aborted) {
+			++next;
+			continue;
+		}
+		ResultKind journal_kind = RESULT_PASS;
+		if (JournaledResult(*job->test, journal_kind)) {
+			RecordIsolatedResult(job, journal_kind);
+			job->resumed = true;
+			++next;
+			continue;
+		}
+		if (CachedPass(*job->test)) {
+			RecordIsolatedResult(job, RESULT_CACHED);
+			++next;
+			continue;
+		}
+		return int32_t(next++);
+	}
+	return -1;
+}
+
+/// @brief Runs all registered tests in a pool of preforked worker processes so crashing tests are recorded as failures without ending the run. A worker that dies is replaced with a fresh fork while jobs remain.
+static bool RunIsolated(uint32_t worker_count)
+{
+	JobTable table;
+	if (table.job_count == 0) {
+		return true;
+	}
+	if (worker_count > table.job_count) {
+		worker_count = table.job_count;
+	}
+
+	// A worker may die while the parent holds a job for it; ignore SIGPIPE for the duration so the write fails softly instead.
+	void (*old_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+
+	cc0::utest::Log().flush();
+
+	WorkerProc *workers = new WorkerProc[worker_count];
+	uint32_t spawned = 0;
+	for (; spawned < worker_count; ++spawned) {
+		if (!SpawnWorker(table, workers[spawned])) {
+			break;
+		}
+	}
+	worker_count = spawned > 0 ? spawned : 0;
+
+	uint32_t next = 0;
+	uint32_t active = 0;
+	for (uint32_t w = 0; w < worker_count; ++w) {
+		const int32_t job = NextIsolatedJob(table, next);
+		if (job < 0) {
+			break;
+		}
+		if (DispatchIsolatedJob(workers[w], table, job)) {
+			++active;
+		}
+	}
+
+	pollfd *fds = new pollfd[worker_count];
+	while (active > 0) {
+		uint32_t fd_count = 0;
+		int wait_ms = -1;
+		const uint64_t now_ns = WallNowNs();
+		for (uint32_t w = 0; w < worker_count; ++w) {
+			if (workers[w].job >= 0) {
+				fds[fd_count].fd = workers[w].from_fd;
+				fds[fd_count].events = POLLIN;
+				fds[fd_count].revents = 0;
+				++fd_count;
+				if (workers[w].deadline_ns != 0) {
+					const int left_ms = workers[w].deadline_ns > now_ns ? int((workers[w].deadline_ns - now_ns) / 1000000ull) + 1 : 0;
+					if (wait_ms < 0 || left_ms < wait_ms) {
+						wait_ms = left_ms;
+					}
+				}
+			}
+		}
+		if (poll(fds, fd_count, wait_ms) < 0) {
+			break;
+		}
+		// Kill any worker that blew its deadline; the pipe EOF below then records the timeout.
+		const uint64_t after_ns = WallNowNs();
+		for (uint32_t w = 0; w < worker_count; ++w) {
+			if (workers[w].job >= 0 && !workers[w].timed_out && workers[w].deadline_ns != 0 && after_ns >= workers[w].deadline_ns) {
+				workers[w].timed_out = true;
+				kill(workers[w].pid, SIGKILL);
+			}
+		}
+		for (uint32_t w = 0; w < worker_count; ++w) {
+			if (workers[w].job < 0) {
+				continue;
+			}
+			bool ready = false;
+			for (uint32_t f = 0; f < fd_count; ++f) {
+				if (fds[f].fd == workers[w].from_fd && fds[f].revents != 0) {
+					ready = true;
+					break;
+				}
+			}
+			if (!ready) {
+				continue;
+			}
+			IsolatedResult result;
+			if (ReadFull(workers[w].from_fd, &result, sizeof(result))) {
+				Job *job = &table.jobs[workers[w].job];
+				job->test->wall_ns = result.wall_ns;
+				job->test->cpu_ns = result.cpu_ns;
+				job->test->alloc_count = result.alloc_count;
+				job->test->peak_bytes = result.peak_bytes;
+				job->test->leaked_bytes = result.leaked_bytes;
+				RecordIsolatedResult(job, result.passed == 2 ? RESULT_FLAKY : result.passed != 0 ? RESULT_PASS : RESULT_FAIL);
+				JournalFinish(*job->test, result.passed != 0);
+			} else {
+				// The worker died mid-test, either by crashing or by being killed for exceeding its deadline. Record the outcome and replace the worker so the pool stays full.
+				Job *job = &table.jobs[workers[w].job];
+				if (workers[w].timed_out) {
+					job->test->wall_ns = uint64_t(EffectiveTimeoutMs(*job->test)) * 1000000ull;
+					RecordIsolatedResult(job, RESULT_TIMEOUT);
+				} else {
+					RecordIsolatedResult(job, RESULT_CRASH);
+				}
+				// The outcome is known even though the worker died, so journal it as a failure rather than leaving the started record.
+				JournalFinish(*job->test, false);
+				::close(workers[w].to_fd);
+				::close(workers[w].from_fd);
+				waitpid(workers[w].pid, nullptr, 0);
+				if (!SpawnWorker(table, workers[w])) {
+					workers[w].job = -1;
+					--active;
+					continue;
+				}
+			}
+			workers[w].job = -1;
+			--active;
+			const int32_t job = NextIsolatedJob(table, next);
+			if (job >= 0 && DispatchIsolatedJob(workers[w], table, job)) {
+				++active;
+			}
+		}
+	}
+	delete [] fds;
+
+	for (uint32_t w = 0; w < worker_count; ++w) {
+		::close(workers[w].to_fd);
+	}
+	for (uint32_t w = 0; w < worker_count; ++w) {
+		waitpid(workers[w].pid, nullptr, 0);
+		::close(workers[w].from_fd);
+	}
+	delete [] workers;
+	signal(SIGPIPE, old_sigpipe);
+
+	return PrintJobResults(table.jobs, table.job_count);
+}
+
+#endif
+
+bool cc0::utest::AddTest(bool (*fn)(), const char *name, const char *context, bool test_must_pass, uint32_t timeout_ms, uint64_t context_hash, uint64_t key, uint32_t name_len)
 {
-	return m_success;
+	ContextItem &c = Contexts().list[FindOrAddContext(context, context_hash != 0 ? context_hash : HashString(context))];
+	if (name_len == 0) {
+		name_len = uint32_t(std::strlen(name));
+	}
+	c.tests.Add(TestItem(fn, name, name_len, test_must_pass, timeout_ms));
+	TestItem &t = c.tests[c.tests.Size() - 1];
+	t.key = key != 0 ? key : HashCombineString(c.hash, name);
+	const uint32_t name_chars = name_len + 3;
+	c.align_chars = c.align_chars > name_chars ? c.align_chars : name_chars;
+	return true;
 }
 
-bool cc0::utest::UTestBase::Failed( void ) const
+bool cc0::utest::AddAsyncTest(bool (*fn)(), const AsyncTest *hooks, const char *name, const char *context, bool test_must_pass, uint32_t timeout_ms, uint64_t context_hash, uint64_t key, uint32_t name_len)
 {
-	return !m_success;
+	AddTest(fn, name, context, test_must_pass, timeout_ms, context_hash, key, name_len);
+	ContextItem &c = Contexts().list[FindOrAddContext(context, context_hash != 0 ? context_hash : HashString(context))];
+	c.tests[c.tests.Size() - 1].async = hooks;
+	return true;
 }
 
-template < typename type_t >
-struct Item
+bool cc0::utest::AddParamTest(bool (*fn)(), const ParamTest *table, const char *name, const char *context, bool test_must_pass, uint32_t timeout_ms, uint64_t context_hash, uint64_t key, uint32_t name_len)
+{
+	AddTest(fn, name, context, test_must_pass, timeout_ms, context_hash, key, name_len);
+	ContextItem &c = Contexts().list[FindOrAddContext(context, context_hash != 0 ? context_hash : HashString(context))];
+	TestItem &t = c.tests[c.tests.Size() - 1];
+	t.param = table;
+	// Variant rows append a "[index]" suffix to the name; widen the column to fit the widest one.
+	uint32_t digits = 1;
+	for (uint32_t highest = table->count > 0 ? table->count - 1 : 0; highest >= 10; highest /= 10) {
+		++digits;
+	}
+	const uint32_t name_chars = t.name_len + digits + 2 + 3;
+	c.align_chars = c.align_chars > name_chars ? c.align_chars : name_chars;
+	return true;
+}
+
+bool cc0::utest::AddTest(const TestDesc &desc)
+{
+	if (desc.async != nullptr) {
+		return AddAsyncTest(desc.test, desc.async, desc.name, desc.context, desc.must_pass, desc.timeout_ms, desc.context_hash, desc.key, desc.name_len);
+	}
+	if (desc.param != nullptr) {
+		return AddParamTest(desc.test, desc.param, desc.name, desc.context, desc.must_pass, desc.timeout_ms, desc.context_hash, desc.key, desc.name_len);
+	}
+	return AddTest(desc.test, desc.name, desc.context, desc.must_pass, desc.timeout_ms, desc.context_hash, desc.key, desc.name_len);
+}
+
+bool cc0::utest::AddFixture(bool (*init)(), bool (*cleanup)(), const char *context)
+{
+	ContextItem &c = Contexts().list[FindOrAddContext(context, HashString(context))];
+	c.init = init;
+	c.cleanup = cleanup;
+	return true;
+}
+
+#if defined(__ELF__) && defined(__GNUC__)
+// The linker synthesizes these when any translation unit places descriptors in the registration sections; weak so a binary without any resolves them to null.
+extern "C" {
+	extern const cc0::utest::TestDesc    __start_cc0utest[]   __attribute__((weak));
+	extern const cc0::utest::TestDesc    __stop_cc0utest[]    __attribute__((weak));
+	extern const cc0::utest::FixtureDesc __start_cc0utestfx[] __attribute__((weak));
+	extern const cc0::utest::FixtureDesc __stop_cc0utestfx[]  __attribute__((weak));
+}
+#endif
+
+/// @brief Moves every descriptor the CC0_UTEST_SECTION_REGISTRY backend placed in the linker sections into the registry. Runs once on the first Run call. Descriptors register in the order the linker laid them out: translation units follow link order, but a compiler may emit the descriptors of one translation unit in reverse declaration order, so tests within a file can list in a different order than under the default backend.
+static void RegisterSectionTests( void )
+{
+#if defined(__ELF__) && defined(__GNUC__)
+	static bool registered = false;
+	if (registered) {
+		return;
+	}
+	registered = true;
+	for (const cc0::utest::FixtureDesc *d = __start_cc0utestfx; d != __stop_cc0utestfx; ++d) {
+		cc0::utest::AddFixture(d->init, d->cleanup, d->context);
+	}
+	for (const cc0::utest::TestDesc *d = __start_cc0utest; d != __stop_cc0utest; ++d) {
+		cc0::utest::AddTest(*d);
+	}
+#endif
+}
+
+void cc0::utest::ForEachTest(void (*callback)(const TestInfo &info, void *user), void *user)
+{
+	RegisterSectionTests();
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			const TestItem &t = ci.tests[i];
+			TestInfo info;
+			info.name = t.name;
+			info.context = ci.name;
+			info.key = t.key;
+			info.wall_ns = t.wall_ns;
+			info.cpu_ns = t.cpu_ns;
+			info.timeout_ms = t.timeout_ms;
+			info.must_pass = t.must_pass;
+			info.last_result = t.last_result;
+			callback(info, user);
+		}
+	}
+}
+
+/// @brief Prints the inventory of every selected test in the active output format without invoking any test function. Historical durations come from the loaded result cache when one is active; tests without history list 0.
+static void ListTests( void )
 {
-	type_t       *data;
-	Item<type_t> *next;
+	std::ostream &out = cc0::utest::Log();
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		if (!ContextEnabled(ci)) {
+			continue;
+		}
+		if (g_format == cc0::utest::OUTPUT_CONSOLE) {
+			out << ci.name << "\n";
+		}
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			TestItem &t = ci.tests[i];
+			if (!t.enabled) {
+				continue;
+			}
+			uint64_t wall_ns = 0;
+			if (g_active_cache != nullptr) {
+				const CacheRecord *rec = g_active_cache->Find(t.key);
+				if (rec != nullptr) {
+					wall_ns = rec->wall_ns;
+				}
+			}
+			if (g_format == cc0::utest::OUTPUT_CONSOLE) {
+				out << "  " << t.name;
+				if (t.must_pass) {
+					out << " (must pass)";
+				}
+				if (wall_ns > 0) {
+					out << " (";
+					PrintMs(out, wall_ns);
+					out << ")";
+				}
+				out << "\n";
+			} else if (g_format == cc0::utest::OUTPUT_TAP) {
+				// A dry run is every test skipped, which TAP spells as an ok with a skip directive.
+				out << "ok " << ++g_emit_count << " - " << ci.name << "::" << t.name << " # skip list\n";
+			} else {
+				out << "{\"context\":";
+				EmitJsonString(out, ci.name);
+				out << ",\"test\":";
+				EmitJsonString(out, t.name);
+				out << ",\"must_pass\":" << (t.must_pass ? "true" : "false") << ",\"timeout_ms\":" << t.timeout_ms << ",\"wall_ns\":" << wall_ns << "}\n";
+				++g_emit_count;
+			}
+		}
+	}
+	EmitStructuredFooter();
+	out.flush();
+}
 
-	Item(type_t *dat) : data(dat), next(nullptr) {}
-	~Item( void ) {
-		delete data;
-		delete next;
+/// @brief Prints a table of the slowest tests of the last run, ordered by wall-clock duration.
+static void PrintSlowest(uint32_t top_count)
+{
+	if (top_count == 0) {
+		return;
+	}
+	struct SlowEntry
+	{
+		const TestItem    *test;
+		const ContextItem *context;
+	};
+	SlowEntry *entries = new SlowEntry[top_count];
+	uint32_t used = 0;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		const ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			const TestItem &test = ci.tests[i];
+			// Filtered, sharded and cached-skip tests never executed and would otherwise pad the table with zero-duration rows.
+			if (!test.enabled || test.last_result < 0) {
+				continue;
+			}
+			uint32_t at = used < top_count ? used : top_count;
+			while (at > 0 && entries[at - 1].test->wall_ns < test.wall_ns) {
+				--at;
+			}
+			if (at >= top_count) {
+				continue;
+			}
+			const uint32_t last = used < top_count ? used : top_count - 1;
+			for (uint32_t k = last; k > at; --k) {
+				entries[k] = entries[k - 1];
+			}
+			entries[at].test = &test;
+			entries[at].context = &ci;
+			if (used < top_count) {
+				++used;
+			}
+		}
 	}
+	std::ostream &out = cc0::utest::Log();
+	out << "slowest tests\n";
+	for (uint32_t i = 0; i < used; ++i) {
+		out << "  " << entries[i].test->name << " (" << entries[i].context->name << "): ";
+		PrintMs(out, entries[i].test->wall_ns);
+		out << " wall, ";
+		PrintMs(out, entries[i].test->cpu_ns);
+		out << " cpu\n";
+	}
+	out.flush();
+	delete [] entries;
+}
+
+/// @brief One candidate test while partitioning the suite into shards.
+struct ShardEntry
+{
+	TestItem *test;
+	uint64_t  cost_ns;
 };
 
-template < typename type_t >
-struct List
+/// @brief Orders shard candidates by descending cost, tie-broken on the stable key so the order is identical on every machine.
+static int CompareShardEntries(const void *a, const void *b)
 {
-	Item<type_t> *first;
-	Item<type_t> *last;
+	const ShardEntry *ea = static_cast<const ShardEntry*>(a);
+	const ShardEntry *eb = static_cast<const ShardEntry*>(b);
+	if (ea->cost_ns != eb->cost_ns) {
+		return ea->cost_ns < eb->cost_ns ? 1 : -1;
+	}
+	return ea->test->key < eb->test->key ? 1 : (ea->test->key > eb->test->key ? -1 : 0);
+}
 
-	List( void ) : first(nullptr), last(nullptr) {}
-	~List( void ) { delete first; }
+/// @brief Disables every test not belonging to the given shard. Without historical data tests are partitioned by stable name hash; when the run has a result cache with recorded durations, a greedy longest-first pass balances shards by runtime instead. Both partitions are deterministic, so machines sharing the same cache file (or none) derive the same split with no coordination.
+static void SelectShard(uint32_t shard_index, uint32_t shard_count)
+{
+	if (shard_count <= 1) {
+		return;
+	}
+	uint32_t test_count = 0;
+	uint64_t known_costs = 0;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		test_count += Contexts().list[c].tests.Size();
+	}
+	ShardEntry *entries = new ShardEntry[test_count];
+	uint32_t e = 0;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			entries[e].test = &ci.tests[i];
+			entries[e].cost_ns = 0;
+			if (g_active_cache != nullptr) {
+				const CacheRecord *rec = g_active_cache->Find(ci.tests[i].key);
+				if (rec != nullptr && rec->wall_ns > 0) {
+					entries[e].cost_ns = rec->wall_ns;
+					++known_costs;
+				}
+			}
+			++e;
+		}
+	}
+	if (known_costs == 0) {
+		for (uint32_t i = 0; i < test_count; ++i) {
+			entries[i].test->enabled = entries[i].test->key % shard_count == shard_index;
+		}
+	} else {
+		qsort(entries, test_count, sizeof(ShardEntry), CompareShardEntries);
+		uint64_t *load = new uint64_t[shard_count];
+		for (uint32_t s = 0; s < shard_count; ++s) {
+			load[s] = 0;
+		}
+		for (uint32_t i = 0; i < test_count; ++i) {
+			uint32_t lightest = 0;
+			for (uint32_t s = 1; s < shard_count; ++s) {
+				if (load[s] < load[lightest]) {
+					lightest = s;
+				}
+			}
+			// A test with no recorded duration still adds a nominal cost so unknown tests spread out instead of piling onto one shard.
+			load[lightest] += entries[i].cost_ns > 0 ? entries[i].cost_ns : 1000000ull;
+			entries[i].test->enabled = lightest == shard_index;
+		}
+		delete [] load;
+	}
+	delete [] entries;
+}
 
-	void Add(type_t *item) {
-		Item<type_t> *i = new Item<type_t>(item);
-		if (first == nullptr) {
-			first = i;
-			last = first;
+/// @brief Matches a glob pattern supporting '*' (any run of characters) and '?' (any one character) against a NUL-terminated string. Iterative with star backtracking, so no recursion and no compiled state beyond the pattern itself.
+static bool GlobMatch(const char *pattern, const char *s)
+{
+	const char *star = nullptr;
+	const char *star_s = nullptr;
+	while (*s != 0) {
+		if (*pattern == '*') {
+			star = pattern++;
+			star_s = s;
+		} else if (*pattern == '?' || *pattern == *s) {
+			++pattern;
+			++s;
+		} else if (star != nullptr) {
+			pattern = star + 1;
+			s = ++star_s;
 		} else {
-			last->next = i;
-			last = last->next;
+			return false;
 		}
 	}
-};
+	while (*pattern == '*') {
+		++pattern;
+	}
+	return *pattern == 0;
+}
 
-struct TestItem
+/// @brief Disables every test whose full "context::name" does not match the glob pattern. The full names are laid out once in a flat arena and each is evaluated exactly once, so the per-test cost during the run stays a single enabled check. Contexts left with no selected test are skipped entirely, including their init and cleanup.
+static void SelectFilter(const char *pattern)
 {
-	bool        (*test)();
-	std::string name;
-	bool        must_pass;
+	if (pattern == nullptr) {
+		return;
+	}
+	uint64_t arena_chars = 0;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			arena_chars += std::strlen(ci.name) + 2 + ci.tests[i].name_len + 1;
+		}
+	}
+	char *arena = new char[arena_chars];
+	char *p = arena;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		const size_t context_len = std::strlen(ci.name);
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			TestItem &t = ci.tests[i];
+			char *full = p;
+			std::memcpy(p, ci.name, context_len);
+			p += context_len;
+			*p++ = ':';
+			*p++ = ':';
+			std::memcpy(p, t.name, t.name_len);
+			p += t.name_len;
+			*p++ = 0;
+			t.enabled = t.enabled && GlobMatch(pattern, full);
+		}
+	}
+	delete [] arena;
+}
 
-	TestItem(bool (*fn)(), const char *test_name, bool test_must_pass = false) : test(fn), name(test_name), must_pass(test_must_pass) {}
+/// @brief Returns whether the context name lies under the given '/'-separated path prefix. The prefix matches whole path segments, so "src/net" does not select "src/network/".
+static bool UnderPrefix(const char *name, const char *prefix)
+{
+	uint32_t n = 0;
+	while (prefix[n] != 0) {
+		if (name[n] != prefix[n]) {
+			return false;
+		}
+		++n;
+	}
+	return n == 0 || prefix[n - 1] == '/' || name[n] == '/' || name[n] == 0;
+}
+
+/// @brief Disables every test outside the subtree of contexts under the given path prefix. Context names are file paths, so the registry already forms a path tree; a context left with no selected test is skipped entirely, including its init and cleanup.
+static void SelectPrefix(const char *prefix)
+{
+	if (prefix == nullptr) {
+		return;
+	}
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		if (UnderPrefix(ci.name, prefix)) {
+			continue;
+		}
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			ci.tests[i].enabled = false;
+		}
+	}
+}
+
+/// @brief One directory node of the context path tree while aggregating rollups. The name points into a context name and is not NUL-terminated.
+struct RollupNode
+{
+	const char *name;
+	uint32_t    name_len;
+	uint32_t    passed;
+	uint32_t    failed;
+	uint64_t    wall_ns;
 };
 
-struct ContextItem
+/// @brief Orders rollup nodes by path for qsort, which lists every subtree directly after its parent.
+static int CompareRollupNodes(const void *a, const void *b)
+{
+	const RollupNode *na = static_cast<const RollupNode*>(a);
+	const RollupNode *nb = static_cast<const RollupNode*>(b);
+	const uint32_t common = na->name_len < nb->name_len ? na->name_len : nb->name_len;
+	const int order = std::memcmp(na->name, nb->name, common);
+	if (order != 0) {
+		return order;
+	}
+	return na->name_len < nb->name_len ? -1 : (na->name_len > nb->name_len ? 1 : 0);
+}
+
+/// @brief Prints the per-subtree rollup of the last run: every directory prefix of the context names, with the aggregated pass and fail counts and wall-clock time of the tests under it. The tree is built from the flat registry on demand, so registration pays nothing for it.
+static void PrintTreeRollup( void )
 {
-	std::string    name;
-	bool           (*init)();
-	bool           (*cleanup)();
-	List<TestItem> tests;
-	uint32_t       align_chars;
+	ContextList &contexts = Contexts();
+	uint32_t max_nodes = 0;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		for (const char *p = contexts.list[c].name; *p != 0; ++p) {
+			if (*p == '/') {
+				++max_nodes;
+			}
+		}
+	}
+	if (max_nodes == 0) {
+		return;
+	}
+	RollupNode *nodes = new RollupNode[max_nodes];
+	uint32_t node_count = 0;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		ContextItem &ci = contexts.list[c];
+		uint32_t passed = 0;
+		uint32_t failed = 0;
+		uint64_t wall_ns = 0;
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			const TestItem &t = ci.tests[i];
+			if (!t.enabled || t.last_result < 0) {
+				continue;
+			}
+			if (t.last_result == 1) {
+				++passed;
+			} else {
+				++failed;
+			}
+			wall_ns += t.wall_ns;
+		}
+		if (passed + failed == 0) {
+			continue;
+		}
+		for (const char *p = ci.name; *p != 0; ++p) {
+			if (*p != '/') {
+				continue;
+			}
+			const uint32_t prefix_len = uint32_t(p - ci.name) + 1;
+			uint32_t n = 0;
+			while (n < node_count && (nodes[n].name_len != prefix_len || std::memcmp(nodes[n].name, ci.name, prefix_len) != 0)) {
+				++n;
+			}
+			if (n == node_count) {
+				nodes[node_count++] = RollupNode{ ci.name, prefix_len, 0, 0, 0 };
+			}
+			nodes[n].passed += passed;
+			nodes[n].failed += failed;
+			nodes[n].wall_ns += wall_ns;
+		}
+	}
+	qsort(nodes, node_count, sizeof(RollupNode), CompareRollupNodes);
+	std::ostream &out = cc0::utest::Log();
+	if (node_count > 0) {
+		out << "context rollup\n";
+	}
+	for (uint32_t n = 0; n < node_count; ++n) {
+		out << "  ";
+		for (uint32_t i = 0; i < nodes[n].name_len; ++i) {
+			out << nodes[n].name[i];
+		}
+		out << ": " << nodes[n].passed << "/" << (nodes[n].passed + nodes[n].failed) << " passed, ";
+		PrintMs(out, nodes[n].wall_ns);
+		out << " wall\n";
+	}
+	out.flush();
+	delete [] nodes;
+}
 
-	explicit ContextItem(const char *context_name) : name(context_name), init(nullptr), cleanup(nullptr), align_chars(0) {}
+/// @brief One candidate test while ordering a context for failure-first scheduling.
+struct ScheduleEntry
+{
+	TestItem test;
+	uint32_t fail_count;
+	uint64_t cost_ns;
+	uint32_t pos;
 };
 
-struct ContextList
+/// @brief Orders schedule candidates by descending recorded fail count, then descending recorded duration, then registration order.
+static int CompareScheduleEntries(const void *a, const void *b)
+{
+	const ScheduleEntry *ea = static_cast<const ScheduleEntry*>(a);
+	const ScheduleEntry *eb = static_cast<const ScheduleEntry*>(b);
+	if (ea->fail_count != eb->fail_count) {
+		return ea->fail_count < eb->fail_count ? 1 : -1;
+	}
+	if (ea->cost_ns != eb->cost_ns) {
+		return ea->cost_ns < eb->cost_ns ? 1 : -1;
+	}
+	return ea->pos < eb->pos ? -1 : (ea->pos > eb->pos ? 1 : 0);
+}
+
+/// @brief One context while ordering the context list for failure-first scheduling.
+struct ContextOrder
 {
-	List<ContextItem>  list;
-	ContextItem       *last_used;
+	uint32_t pos;
+	uint32_t max_fails;
+	uint64_t cost_ns;
 };
 
-static ContextList &Contexts( void ) {
-	static ContextList tests;
-	return tests;
+/// @brief Orders contexts by the descending highest fail count among their tests, then descending recorded duration, then registration order.
+static int CompareContextOrder(const void *a, const void *b)
+{
+	const ContextOrder *ca = static_cast<const ContextOrder*>(a);
+	const ContextOrder *cb = static_cast<const ContextOrder*>(b);
+	if (ca->max_fails != cb->max_fails) {
+		return ca->max_fails < cb->max_fails ? 1 : -1;
+	}
+	if (ca->cost_ns != cb->cost_ns) {
+		return ca->cost_ns < cb->cost_ns ? 1 : -1;
+	}
+	return ca->pos < cb->pos ? -1 : (ca->pos > cb->pos ? 1 : 0);
 }
 
-static ContextItem *FindContext(const char *name)
+/// @brief Reorders the suite so tests with recorded failures run first, using the consecutive fail counts the result cache already tracks. The remainder runs slowest-first from the recorded durations so a parallel run packs well, with registration order breaking ties. Contexts are reordered by the same ranking, so the fastest feedback comes first in serial runs too, and the context index is rebuilt to match. Without a loaded cache the order is left unchanged.
+static void ScheduleFailuresFirst( void )
 {
+	if (g_active_cache == nullptr) {
+		return;
+	}
 	ContextList &contexts = Contexts();
-	if (contexts.last_used == nullptr || contexts.last_used->name != name) {
-		Item<ContextItem> *c = contexts.list.first;
-		while (c != nullptr) {
-			if (c->data->name == name) {
-				break;
+	uint32_t max_tests = 0;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		const uint32_t n = contexts.list[c].tests.Size();
+		max_tests = max_tests > n ? max_tests : n;
+	}
+	if (max_tests == 0) {
+		return;
+	}
+	ScheduleEntry *entries = new ScheduleEntry[max_tests];
+	ContextOrder *order = new ContextOrder[contexts.list.Size()];
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		ContextItem &ci = contexts.list[c];
+		order[c].pos = c;
+		order[c].max_fails = 0;
+		order[c].cost_ns = 0;
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			entries[i].test = ci.tests[i];
+			entries[i].fail_count = 0;
+			entries[i].cost_ns = 0;
+			entries[i].pos = i;
+			const CacheRecord *rec = g_active_cache->Find(ci.tests[i].key);
+			if (rec != nullptr) {
+				entries[i].fail_count = rec->fail_count;
+				entries[i].cost_ns = rec->wall_ns;
 			}
-			c = c->next;
+			order[c].max_fails = order[c].max_fails > entries[i].fail_count ? order[c].max_fails : entries[i].fail_count;
+			order[c].cost_ns = order[c].cost_ns > entries[i].cost_ns ? order[c].cost_ns : entries[i].cost_ns;
+		}
+		qsort(entries, ci.tests.Size(), sizeof(ScheduleEntry), CompareScheduleEntries);
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			ci.tests[i] = entries[i].test;
 		}
-		contexts.last_used = c != nullptr ? c->data : nullptr;
 	}
-	return contexts.last_used;
+	qsort(order, contexts.list.Size(), sizeof(ContextOrder), CompareContextOrder);
+	Array<ContextItem> sorted;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		sorted.Add(static_cast<ContextItem&&>(contexts.list[order[c].pos]));
+	}
+	contexts.list = static_cast<Array<ContextItem>&&>(sorted);
+	contexts.index.Rebuild(contexts.list);
+	delete [] order;
+	delete [] entries;
+}
+
+/// @brief Advances a splitmix64 generator and returns the next value. Deterministic for a given seed on every platform, so a printed shuffle seed replays the same order anywhere.
+static uint64_t NextRandom(uint64_t &state)
+{
+	state += 0x9e3779b97f4a7c15ull;
+	uint64_t z = state;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
 }
 
-static ContextItem *FindOrAddContext(const char *name)
+/// @brief Reorders the suite into the deterministic pseudo-random order derived from the seed: a Fisher-Yates pass over the context list, then one over the tests within each context. Tests swap in place on flat index arithmetic and contexts move through a scratch array once, so reordering a large registry costs two linear passes.
+static void ShuffleOrder(uint64_t seed)
 {
 	ContextList &contexts = Contexts();
-	FindContext(name);
-	if (contexts.last_used == nullptr) {
-		contexts.list.Add(new ContextItem(name));
-		contexts.last_used = contexts.list.last->data;
+	uint64_t state = seed;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		Array<TestItem> &tests = contexts.list[c].tests;
+		for (uint32_t i = tests.Size(); i > 1; --i) {
+			const uint32_t j = uint32_t(NextRandom(state) % i);
+			const TestItem tmp = tests[i - 1];
+			tests[i - 1] = tests[j];
+			tests[j] = tmp;
+		}
+	}
+	if (contexts.list.Size() < 2) {
+		return;
 	}
-	return contexts.last_used;
+	uint32_t *order = new uint32_t[contexts.list.Size()];
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		order[c] = c;
+	}
+	for (uint32_t i = contexts.list.Size(); i > 1; --i) {
+		const uint32_t j = uint32_t(NextRandom(state) % i);
+		const uint32_t tmp = order[i - 1];
+		order[i - 1] = order[j];
+		order[j] = tmp;
+	}
+	Array<ContextItem> shuffled;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		shuffled.Add(static_cast<ContextItem&&>(contexts.list[order[c]]));
+	}
+	contexts.list = static_cast<Array<ContextItem>&&>(shuffled);
+	contexts.index.Rebuild(contexts.list);
+	delete [] order;
 }
 
-static void PrintTestName(const std::string &class_name, uint32_t align_chars)
+/// @brief One entry of the flat execution order the order-dependency bisection probes.
+struct OrderEntry
+{
+	const ContextItem *context;
+	const TestItem    *test;
+};
+
+/// @brief Binary-searches the executed order for a minimal failing pair after a shuffled run recorded a failure. The victim is the first failed test of the order; each probe round re-runs a window of earlier tests followed by the victim and halves the window on the outcome, so a single polluting test is found in O(log n) rounds. Probes invoke the test bodies directly in this process without timing or journaling, so the helper assumes the dependency reproduces under repetition; a victim that still fails with no earlier tests, or a dependency spread over several tests, is reported as such instead of a pair.
+static void BisectOrder( void )
 {
-	std::cout << "  ";
-	for (size_t i = 0, j = 0; i < class_name.size(); i = j) {
-		j = class_name.find('_', i);
-		std::cout << class_name.substr(i, (j - i)) << " ";
-		if (j < std::string::npos) {
-			++j;
+	ContextList &contexts = Contexts();
+	uint32_t count = 0;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		count += contexts.list[c].tests.Size();
+	}
+	if (count == 0) {
+		return;
+	}
+	OrderEntry *order = new OrderEntry[count];
+	uint32_t used = 0;
+	uint32_t victim = count;
+	for (uint32_t c = 0; c < contexts.list.Size(); ++c) {
+		const ContextItem &ci = contexts.list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			if (!ci.tests[i].enabled || ci.tests[i].last_result < 0) {
+				continue;
+			}
+			if (victim == count && ci.tests[i].last_result == 0) {
+				victim = used;
+			}
+			order[used].context = &ci;
+			order[used].test = &ci.tests[i];
+			++used;
+		}
+	}
+	std::ostream &out = cc0::utest::Log();
+	if (victim >= used) {
+		delete [] order;
+		return;
+	}
+	out << "order bisection\n";
+	const OrderEntry &v = order[victim];
+	// Probe results are discarded, so the diagnostics the replayed bodies emit are muted to keep the verdict lines whole.
+	g_mute_reports = true;
+	const bool passes_alone = v.test->test();
+	if (!passes_alone) {
+		g_mute_reports = false;
+		out << "  " << v.test->name << " (" << v.context->name << ") fails alone; not an order dependency (or the process state is already polluted)\n";
+		out.flush();
+		delete [] order;
+		return;
+	}
+	if (victim == 0) {
+		g_mute_reports = false;
+		out << "  " << v.test->name << " (" << v.context->name << ") failed first in the order yet passes alone; the failure does not reproduce\n";
+		out.flush();
+		delete [] order;
+		return;
+	}
+	uint32_t lo = 0;
+	uint32_t hi = victim;
+	while (hi - lo > 1) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		for (uint32_t i = lo; i < mid; ++i) {
+			order[i].test->test();
+		}
+		if (!v.test->test()) {
+			hi = mid;
+		} else {
+			lo = mid;
 		}
 	}
-	std::cout << "\x8";
-	for (uint32_t i = 0; i < align_chars - class_name.size(); ++i) {
-		std::cout << ".";
+	const OrderEntry &culprit = order[lo];
+	culprit.test->test();
+	const bool reproduced = !v.test->test();
+	g_mute_reports = false;
+	if (reproduced) {
+		out << "  " << v.test->name << " (" << v.context->name << ") fails after " << culprit.test->name << " (" << culprit.context->name << ")\n";
+	} else {
+		out << "  no single earlier test makes " << v.test->name << " (" << v.context->name << ") fail; the dependency involves several tests\n";
 	}
-	std::cout << std::flush;
+	out.flush();
+	delete [] order;
 }
 
-static bool RunTests(List<TestItem> &tests, uint32_t align_chars)
+/// @brief Folds the outcome of every test that executed this run back into the active result cache.
+static void UpdateCacheFromRegistry( void )
 {
-	bool status = true;
-	for (auto i = tests.first; i != nullptr; i = i->next) {
-		PrintTestName(i->data->name, align_chars);
-		if (!i->data->test()) {
-			status = false;
-			std::cout << "\n    fail" << std::endl;
-			if (i->data->must_pass) {
-				std::cout << "  [abort]" << std::endl;
-				break;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			TestItem &test = ci.tests[i];
+			if (test.last_result < 0) {
+				continue;
 			}
-		} else {
-			std::cout << "ok" << std::endl;
+			CacheRecord &rec = g_active_cache->FindOrAdd(test.key);
+			rec.fingerprint = FingerprintFunction(test.test);
+			rec.wall_ns = test.wall_ns;
+			rec.passed = test.last_result == 1 ? 1 : 0;
+			rec.fail_count = test.last_result == 1 ? 0 : rec.fail_count + 1;
+			rec.run_count += 1;
+			rec.flaky_count += test.last_flaky ? 1 : 0;
 		}
 	}
-	return status;
 }
 
-static bool RunContext(ContextItem *c)
+/// @brief Prints every registered test with a recorded flaky pass in the active result cache, with its flake rate, as quarantine candidates. The list persists with the cache, so the worst offenders stay visible on every run even when they happen to pass cleanly.
+static void PrintFlakeReport( void )
 {
-	bool status = true;
-	std::cout << c->name << std::endl;
-	if ((c->init != nullptr && !c->init()) || !RunTests(c->tests, c->align_chars)) {
-		status = false;
+	std::ostream &out = cc0::utest::Log();
+	bool header = false;
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		ContextItem &ci = Contexts().list[c];
+		for (uint32_t i = 0; i < ci.tests.Size(); ++i) {
+			const CacheRecord *rec = g_active_cache->Find(ci.tests[i].key);
+			if (rec == nullptr || rec->flaky_count == 0) {
+				continue;
+			}
+			if (!header) {
+				out << "quarantine candidates\n";
+				header = true;
+			}
+			out << "  " << ci.name << "::" << ci.tests[i].name << ": flaky " << rec->flaky_count << "/" << rec->run_count << " runs\n";
+		}
 	}
-	if (c->cleanup != nullptr && !c->cleanup()) {
-		status = false;
+	if (header) {
+		out.flush();
 	}
-	std::cout << "  " << (status ? "[ok]" : "[fail]") << std::endl;
-	return status;
 }
 
-bool cc0::utest::AddTest(bool (*fn)(), const char *name, const char *context, bool test_must_pass)
+/// @brief Orders duration samples ascending for qsort.
+static int CompareSamples(const void *a, const void *b)
 {
-	ContextItem *c = FindOrAddContext(context);
-	c->tests.Add(new TestItem(fn, name, test_must_pass));
-	c->align_chars = c->align_chars > uint32_t(c->tests.last->data->name.size()) + 3 ? c->align_chars : uint32_t(c->tests.last->data->name.size()) + 3;
-	return true;
+	const uint64_t sa = *static_cast<const uint64_t*>(a);
+	const uint64_t sb = *static_cast<const uint64_t*>(b);
+	return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
+
+/// @brief Runs every selected test repeatedly and reports min, median and p99 durations per test. Timing wraps only the test invocation itself; warmup iterations, sample sorting and output all happen outside the timed region, and the sample buffer is allocated once and reused across tests.
+static bool RunBenchmarks(uint32_t warmup, uint32_t iterations)
+{
+	std::ostream &out = cc0::utest::Log();
+	const bool console = g_format == cc0::utest::OUTPUT_CONSOLE;
+	uint64_t *samples = new uint64_t[iterations];
+	bool status = true;
+	for (uint32_t ci = 0; ci < Contexts().list.Size(); ++ci) {
+		ContextItem &c = Contexts().list[ci];
+		if (!ContextEnabled(c)) {
+			continue;
+		}
+		bool ctx_status = true;
+		if (console) {
+			out << c.name << "\n";
+		}
+		if (c.init != nullptr && !c.init()) {
+			ctx_status = false;
+		} else {
+			for (uint32_t i = 0; i < c.tests.Size(); ++i) {
+				TestItem &t = c.tests[i];
+				if (!t.enabled) {
+					continue;
+				}
+				if (console) {
+					PrintTestName(t.name, t.name_len, c.align_chars);
+				}
+				bool passed = true;
+				for (uint32_t w = 0; w < warmup && passed; ++w) {
+					passed = t.test();
+				}
+				uint32_t n = 0;
+				for (; n < iterations && passed; ++n) {
+					const uint64_t start = WallNowNs();
+					passed = t.test();
+					samples[n] = WallNowNs() - start;
+				}
+				t.last_result = passed ? 1 : 0;
+				if (passed) {
+					qsort(samples, n, sizeof(uint64_t), CompareSamples);
+					t.wall_ns = samples[n / 2];
+					if (console) {
+						out << "min ";
+						PrintMs(out, samples[0]);
+						out << "  med ";
+						PrintMs(out, samples[n / 2]);
+						out << "  p99 ";
+						PrintMs(out, samples[(uint64_t(n - 1) * 99 + 50) / 100]);
+						out << "\n";
+						out.flush();
+					} else {
+						EmitStructuredResult(c, t, RESULT_PASS);
+					}
+				} else {
+					ctx_status = false;
+					t.wall_ns = 0;
+					if (console) {
+						out << "\n    fail\n";
+						out.flush();
+					} else {
+						EmitStructuredResult(c, t, RESULT_FAIL);
+					}
+					if (t.must_pass) {
+						if (console) {
+							out << "  [abort]\n";
+							out.flush();
+						}
+						break;
+					}
+				}
+			}
+		}
+		if (c.cleanup != nullptr && !c.cleanup()) {
+			ctx_status = false;
+		}
+		uint64_t total_ns = 0;
+		for (uint32_t i = 0; i < c.tests.Size(); ++i) {
+			if (c.tests[i].enabled) {
+				total_ns += c.tests[i].wall_ns;
+			}
+		}
+		if (console) {
+			out << "  " << (ctx_status ? "[ok]" : "[fail]") << " (";
+			PrintMs(out, total_ns);
+			out << ")\n";
+			out.flush();
+		} else {
+			EmitStructuredContext(c, ctx_status, total_ns);
+		}
+		status = status && ctx_status;
+	}
+	delete [] samples;
+	return status;
 }
 
+cc0::utest::RunOptions::RunOptions( void ) : thread_count(1), isolate_tests(false), slowest_count(0), default_timeout_ms(0), cache_file(nullptr), incremental(false), journal_file(nullptr), journal_sync_every(0), failures_first(false), shuffle(false), shuffle_seed(0), bisect_order(false), max_failures(0), retry_count(0), retry_backoff_ms(0), track_memory(false), update_golden(false), progress(false), trace_file(nullptr), list_only(false), format(OUTPUT_CONSOLE), shard_index(0), shard_count(0), filter(nullptr), context_prefix(nullptr), context_rollup(false), bench_iterations(0), bench_warmup(1)
+{}
+
 int cc0::utest::Run( void )
 {
+	RegisterSectionTests();
 	bool status = true;
-	for (auto c = Contexts().list.first; c != nullptr; c = c->next) {
-		if (!RunContext(c->data)) {
+	for (uint32_t c = 0; c < Contexts().list.Size(); ++c) {
+		if (!RunContext(&Contexts().list[c])) {
 			status = false;
 		}
 	}
 	return status ? 0 : 1;
 }
 
+int cc0::utest::Run(const RunOptions &options)
+{
+	RegisterSectionTests();
+	if (options.shard_count > 1 && options.shard_index >= options.shard_count) {
+		// A shard index outside the split selects nothing; failing loudly beats a CI leg reporting green without running a test.
+		std::ostream &out = Log();
+		out << "shard " << options.shard_index << " does not exist (" << options.shard_count << " shards)\n";
+		out.flush();
+		return 1;
+	}
+	uint32_t thread_count = options.thread_count;
+	if (thread_count == 0) {
+		thread_count = std::thread::hardware_concurrency();
+		if (thread_count == 0) {
+			thread_count = 1;
+		}
+	}
+	g_default_timeout_ms = options.default_timeout_ms;
+	g_track_memory = options.track_memory;
+	g_update_golden = options.update_golden;
+	g_retry_count = options.retry_count;
+	g_retry_backoff_ms = options.retry_backoff_ms;
+	g_format = options.format;
+	g_emit_count = 0;
+	if (options.trace_file != nullptr && !options.list_only) {
+		g_trace_active = true;
+		g_trace_origin = WallNowNs();
+	}
+
+	ResultCache cache;
+	if (options.cache_file != nullptr) {
+		cache.Load(options.cache_file);
+		g_active_cache = &cache;
+		g_incremental = options.incremental;
+	}
+	ResultJournal journal;
+	if (options.journal_file != nullptr && !options.list_only && journal.Open(options.journal_file, options.journal_sync_every)) {
+		g_active_journal = &journal;
+	}
+	SelectShard(options.shard_index, options.shard_count);
+	SelectFilter(options.filter);
+	SelectPrefix(options.context_prefix);
+	if (options.list_only) {
+		// Inventory only: the selection above has been applied, nothing executes, and the loaded cache is left untouched.
+		ListTests();
+		if (options.shard_count > 1 || options.filter != nullptr || options.context_prefix != nullptr) {
+			RestoreEnabled();
+		}
+		g_active_cache = nullptr;
+		g_incremental = false;
+		g_default_timeout_ms = 0;
+		g_track_memory = false;
+		g_update_golden = false;
+		g_retry_count = 0;
+		g_retry_backoff_ms = 0;
+		g_format = OUTPUT_CONSOLE;
+		return 0;
+	}
+	if (options.failures_first) {
+		ScheduleFailuresFirst();
+	}
+	if (options.shuffle) {
+		const uint64_t seed = options.shuffle_seed != 0 ? options.shuffle_seed : (WallNowNs() | 1);
+		ShuffleOrder(seed);
+		if (g_format == OUTPUT_CONSOLE) {
+			Log() << "shuffle seed " << seed << "\n";
+		}
+	}
+	if (options.max_failures > 0) {
+		g_failure_budget = int64_t(options.max_failures);
+	}
+	if (options.progress && options.bench_iterations == 0) {
+		ProgressInit();
+	}
+
+	int code;
+	if (options.bench_iterations > 0) {
+		code = RunBenchmarks(options.bench_warmup, options.bench_iterations) ? 0 : 1;
+	} else
+#if defined(CC0_UTEST_POSIX)
+	if (options.isolate_tests) {
+		code = RunIsolated(thread_count) ? 0 : 1;
+	} else
+#endif
+	if (thread_count == 1) {
+		code = Run();
+	} else {
+		code = RunParallel(thread_count) ? 0 : 1;
+	}
+
+	ProgressFinish();
+	if (g_trace_active) {
+		TraceAdd(nullptr, "run", "suite", g_trace_origin, WallNowNs() - g_trace_origin);
+		g_trace_active = false;
+		WriteTrace(options.trace_file);
+		TraceBuffer() = Array<TraceSpan>();
+	}
+	if (options.shuffle && options.bisect_order && code != 0 && g_format == OUTPUT_CONSOLE) {
+		BisectOrder();
+	}
+	if (g_active_cache != nullptr) {
+		UpdateCacheFromRegistry();
+		cache.Save(options.cache_file);
+		if (g_format == OUTPUT_CONSOLE) {
+			PrintFlakeReport();
+		}
+		g_active_cache = nullptr;
+		g_incremental = false;
+	}
+	if (g_active_journal != nullptr) {
+		g_active_journal->Close();
+		g_active_journal = nullptr;
+		// The run completed; the journal only needs to survive a crash.
+		std::remove(options.journal_file);
+	}
+	g_default_timeout_ms = 0;
+	g_track_memory = false;
+	g_update_golden = false;
+	g_retry_count = 0;
+	g_retry_backoff_ms = 0;
+	g_failure_budget = int64_t(1) << 62;
+	ReleaseGoldenCache();
+	if (options.shard_count > 1 || options.filter != nullptr || options.context_prefix != nullptr) {
+		RestoreEnabled();
+	}
+	EmitStructuredFooter();
+	if (g_format == OUTPUT_CONSOLE) {
+		if (options.context_rollup) {
+			PrintTreeRollup();
+		}
+		PrintSlowest(options.slowest_count);
+	}
+	g_format = OUTPUT_CONSOLE;
+	return code;
+}
+
+int cc0::utest::Run(const char *context_prefix)
+{
+	RunOptions options;
+	options.context_prefix = context_prefix;
+	options.context_rollup = true;
+	return Run(options);
+}
+
+int cc0::utest::Run(uint32_t shard_index, uint32_t shard_count)
+{
+	RunOptions options;
+	options.shard_index = shard_index;
+	options.shard_count = shard_count;
+	return Run(options);
+}
+
 int cc0::utest::Run(const char **contexts, uint32_t count)
 {
+	RegisterSectionTests();
 	bool status = true;
 	for (uint32_t c = 0; c < count; ++c) {
-		FindContext(contexts[c]);
-		if (Contexts().last_used != nullptr) {
-			if (!RunContext(Contexts().last_used)) {
+		const uint32_t ci = FindContext(contexts[c]);
+		if (ci != NO_CONTEXT) {
+			if (!RunContext(&Contexts().list[ci])) {
 				status = false;
 			}
 		} else {
-			std::cout << contexts[c] << "...not found" << std::endl;
+			cc0::utest::Log() << contexts[c] << "...not found" << std::endl;
 			status = false;
 		}
 	}
@@ -8,7 +8,10 @@
 #define CC0_UTEST_H_INCLUDED__
 
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <type_traits>
 
 /// @brief Begins the definition of a user-defined unit test.
 /// @param unit_class The class name of the unit test. Be descriptive as this will be the basis for the description of the test.
@@ -19,6 +22,16 @@
 	public: \
 		unit_class( void ) : UTestBase()
 
+// Defining CC0_UTEST_SECTION_REGISTRY before including this header switches the registration macros to the linker-section backend on platforms that support it: instead of a namespace-scope bool whose dynamic initializer calls the registration function before main, each macro places a constant-initialized descriptor into a dedicated section that Run() walks through the linker-provided start/stop symbols. A binary with tens of thousands of tests then spends no pre-main time registering and the descriptor array pages in on first use. Registration order is the section layout the linker produced, which can differ from the default backend within one translation unit (compilers may emit a file's section objects in reverse declaration order). On toolchains without ELF sections the macros silently keep the default backend.
+#if defined(CC0_UTEST_SECTION_REGISTRY) && defined(__ELF__) && defined(__GNUC__)
+	#define CC0_UTEST_REGISTER_DESC__(unit_class, hooks, table, must_pass, timeout_ms) \
+		__attribute__((section("cc0utest"), used, aligned(alignof(cc0::utest::TestDesc)))) const static cc0::utest::TestDesc unit_class##_desc = { run_##unit_class, hooks, table, #unit_class, __FILE__, cc0::utest::HashName(__FILE__), cc0::utest::HashName(#unit_class, cc0::utest::HashName(__FILE__)), cc0::utest::NameLength(#unit_class), timeout_ms, must_pass };
+#else
+	#define CC0_UTEST_REGISTER_DESC__(unit_class, hooks, table, must_pass, timeout_ms) \
+		const static cc0::utest::TestDesc unit_class##_desc = { run_##unit_class, hooks, table, #unit_class, __FILE__, cc0::utest::HashName(__FILE__), cc0::utest::HashName(#unit_class, cc0::utest::HashName(__FILE__)), cc0::utest::NameLength(#unit_class), timeout_ms, must_pass }; \
+		const static bool unit_class##_fn_added = cc0::utest::AddTest(unit_class##_desc);
+#endif
+
 /// @brief Ends a user-defined unit test.
 /// @param unit_class The same class name used when beginning to define the test using CC0_UTEST_BEGIN.
 /// @param must_pass If true, halts further tests from running within this context when this test fails.
@@ -26,18 +39,155 @@
 #define CC0_UTEST_END(unit_class, must_pass) \
 	}; \
 	static bool run_##unit_class( void ) { return unit_class().Succeeded(); } \
-	const static bool unit_class##_fn_added = cc0::utest::AddTest(run_##unit_class, #unit_class, __FILE__, must_pass);
+	CC0_UTEST_REGISTER_DESC__(unit_class, nullptr, nullptr, must_pass, 0)
+
+/// @brief Ends a user-defined unit test with a deadline.
+/// @param unit_class The same class name used when beginning to define the test using CC0_UTEST_BEGIN.
+/// @param must_pass If true, halts further tests from running within this context when this test fails.
+/// @param timeout_ms The deadline in milliseconds after which the test is abandoned and recorded as a timeout failure. 0 falls back to the default deadline of the run.
+/// @sa CC0_UTEST_BEGIN
+#define CC0_UTEST_END_TIMED(unit_class, must_pass, timeout_ms) \
+	}; \
+	static bool run_##unit_class( void ) { return unit_class().Succeeded(); } \
+	CC0_UTEST_REGISTER_DESC__(unit_class, nullptr, nullptr, must_pass, timeout_ms)
+
+/// @brief Begins the definition of a user-defined asynchronous unit test, whose body is a Step function invoked in slices by an event loop.
+/// @param unit_class The class name of the unit test. Be descriptive as this will be the basis for the description of the test.
+/// @note A Step slice should poll for whatever the test is waiting on and return rather than block, so the event loop can advance other pending tests in the meantime. Call Done() once the test has finished; a failed assertion ends the test as usual.
+/// @sa CC0_UTEST_ASYNC_END
+#define CC0_UTEST_ASYNC_BEGIN(unit_class) \
+	class unit_class : public cc0::utest::UTestAsyncBase { \
+	public: \
+		void Step( void )
+
+/// @brief Ends a user-defined asynchronous unit test.
+/// @param unit_class The same class name used when beginning to define the test using CC0_UTEST_ASYNC_BEGIN.
+/// @param must_pass If true, halts further tests from running within this context when this test fails.
+/// @sa CC0_UTEST_ASYNC_BEGIN
+#define CC0_UTEST_ASYNC_END(unit_class, must_pass) \
+	}; \
+	static void *create_##unit_class( void ) { return new unit_class; } \
+	static bool step_##unit_class(void *t) { unit_class *u = static_cast<unit_class*>(t); u->Step(); return u->Pending() && u->Succeeded(); } \
+	static bool succeeded_##unit_class(void *t) { const unit_class *u = static_cast<unit_class*>(t); return u->Succeeded() && !u->Pending(); } \
+	static void destroy_##unit_class(void *t) { delete static_cast<unit_class*>(t); } \
+	static bool run_##unit_class( void ) { void *t = create_##unit_class(); while (step_##unit_class(t)) {} const bool ok = succeeded_##unit_class(t); destroy_##unit_class(t); return ok; } \
+	const static cc0::utest::AsyncTest unit_class##_hooks = { create_##unit_class, step_##unit_class, succeeded_##unit_class, destroy_##unit_class }; \
+	CC0_UTEST_REGISTER_DESC__(unit_class, &unit_class##_hooks, nullptr, must_pass, 0)
+
+/// @brief Begins the definition of a user-defined parameterized unit test, whose body runs once per entry of a parameter table.
+/// @param unit_class The class name of the unit test. Be descriptive as this will be the basis for the description of the test.
+/// @param param_type_t The element type of the parameter table. The body receives one entry as `param`.
+/// @note One class and one registration cover the whole table; the variants are expanded into result rows at run time, so a large table adds no per-variant code or static-init work.
+/// @sa CC0_UTEST_PARAM_END
+#define CC0_UTEST_PARAM_BEGIN(unit_class, param_type_t) \
+	class unit_class : public cc0::utest::UTestBase { \
+	public: \
+		typedef param_type_t param_type; \
+		explicit unit_class(const param_type &param) : UTestBase()
+
+/// @brief Ends a user-defined parameterized unit test.
+/// @param unit_class The same class name used when beginning to define the test using CC0_UTEST_PARAM_BEGIN.
+/// @param must_pass If true, halts further tests from running within this context when this test fails (any failing variant fails the test).
+/// @param table An array of parameters, one per variant. Must outlive the run; the registry stores a pointer rather than a copy.
+/// @sa CC0_UTEST_PARAM_BEGIN
+#define CC0_UTEST_PARAM_END(unit_class, must_pass, table) \
+	}; \
+	static bool run_one_##unit_class(const void *p) { return unit_class(*static_cast<const unit_class::param_type*>(p)).Succeeded(); } \
+	static bool run_##unit_class( void ) { bool ok = true; for (uint32_t cc0_utest_v_ = 0; cc0_utest_v_ < uint32_t(sizeof(table) / sizeof((table)[0])); ++cc0_utest_v_) { ok &= run_one_##unit_class(&(table)[cc0_utest_v_]); } return ok; } \
+	const static cc0::utest::ParamTest unit_class##_table = { run_one_##unit_class, table, uint32_t(sizeof(table) / sizeof((table)[0])), uint32_t(sizeof((table)[0])) }; \
+	CC0_UTEST_REGISTER_DESC__(unit_class, nullptr, &unit_class##_table, must_pass, 0)
+
+/// @brief Registers an init and a cleanup function for the context of the current file.
+/// @param init_fn A function of signature bool(), run once before the first test in the context. Returning false fails the context and skips its tests.
+/// @param cleanup_fn A function of signature bool(), run once after the last test in the context. Returning false fails the context.
+/// @note Registering a second fixture for the same context replaces the first. Under process isolation init and cleanup run once per worker process instead, since process state is not shared.
+/// @sa cc0::utest::SharedState
+#if defined(CC0_UTEST_SECTION_REGISTRY) && defined(__ELF__) && defined(__GNUC__)
+	#define CC0_UTEST_FIXTURE(init_fn, cleanup_fn) \
+		__attribute__((section("cc0utestfx"), used, aligned(alignof(cc0::utest::FixtureDesc)))) const static cc0::utest::FixtureDesc init_fn##_fixture_desc = { init_fn, cleanup_fn, __FILE__ };
+#else
+	#define CC0_UTEST_FIXTURE(init_fn, cleanup_fn) \
+		const static bool init_fn##_fixture_added = cc0::utest::AddFixture(init_fn, cleanup_fn, __FILE__);
+#endif
 
 /// @brief Exits a unit test if the test is not true.
 /// @param l The left operand.
 /// @param op The comparison operator (or any other operator that will yeild a boolean expression).
 /// @param r The right operand.
+/// @note The operands are evaluated exactly once. The passing path is a compare and a counter increment; formatting of the failure message happens in a cold out-of-line function only when the assert fails.
 #define CC0_UTEST_ASSERT(l, op, r) \
-	IncrementAssertCount(); \
-	if (!((l) op (r))) { \
-		Fail(); \
-		std::cout << "\n    #" << AssertCount() << " @" << __LINE__ << ": <<" << (l) << " " << #op << " " << (r) << ">> is false"; \
-		return; \
+	{ \
+		IncrementAssertCount(); \
+		const auto &cc0_utest_l_ = (l); \
+		const auto &cc0_utest_r_ = (r); \
+		if (!(cc0_utest_l_ op cc0_utest_r_)) { \
+			Fail(); \
+			cc0::utest::ReportAssertFailure(AssertCount(), __LINE__, cc0_utest_l_, #op, cc0_utest_r_); \
+			return; \
+		} \
+	}
+
+/// @brief Records a failed expectation without exiting the unit test.
+/// @param l The left operand.
+/// @param op The comparison operator (or any other operator that will yeild a boolean expression).
+/// @param r The right operand.
+/// @note The soft counterpart of CC0_UTEST_ASSERT: the test keeps running past a failure, so one run surfaces every broken expectation instead of only the first. Each failure is reported as it happens, recorded into a small fixed-capacity ring buffer on the test (no heap allocation), and summarized together when the test object is destroyed. The test still fails if any expectation failed.
+#define CC0_UTEST_EXPECT(l, op, r) \
+	{ \
+		IncrementAssertCount(); \
+		const auto &cc0_utest_l_ = (l); \
+		const auto &cc0_utest_r_ = (r); \
+		if (!(cc0_utest_l_ op cc0_utest_r_)) { \
+			RecordSoftFailure(__LINE__); \
+			cc0::utest::ReportAssertFailure(AssertCount(), __LINE__, cc0_utest_l_, #op, cc0_utest_r_); \
+		} \
+	}
+
+/// @brief Exits a unit test if two buffers are not element-wise equal.
+/// @param a The pointer to the first buffer.
+/// @param b The pointer to the second buffer.
+/// @param count The number of elements compared.
+/// @note Counts as a single assertion regardless of count. On failure the index and value pair of the first diverging element are reported.
+#define CC0_UTEST_ASSERT_RANGE(a, b, count) \
+	{ \
+		const auto *cc0_utest_a_ = (a); \
+		const auto *cc0_utest_b_ = (b); \
+		const uint64_t cc0_utest_n_ = (count); \
+		uint64_t cc0_utest_i_ = 0; \
+		if (!AssertRange(cc0_utest_a_, cc0_utest_b_, cc0_utest_n_, cc0_utest_i_)) { \
+			cc0::utest::ReportRangeFailure(AssertCount(), __LINE__, cc0_utest_i_, cc0_utest_a_[cc0_utest_i_], cc0_utest_b_[cc0_utest_i_]); \
+			return; \
+		} \
+	}
+
+/// @brief Exits a unit test if two buffers diverge element-wise by more than the given tolerance.
+/// @param a The pointer to the first buffer.
+/// @param b The pointer to the second buffer.
+/// @param count The number of elements compared.
+/// @param epsilon The maximum allowed absolute difference between an element pair.
+/// @note Counts as a single assertion regardless of count. On failure the index and value pair of the first diverging element are reported.
+#define CC0_UTEST_ASSERT_RANGE_NEAR(a, b, count, epsilon) \
+	{ \
+		const auto *cc0_utest_a_ = (a); \
+		const auto *cc0_utest_b_ = (b); \
+		const uint64_t cc0_utest_n_ = (count); \
+		uint64_t cc0_utest_i_ = 0; \
+		if (!AssertRangeNear(cc0_utest_a_, cc0_utest_b_, cc0_utest_n_, (epsilon), cc0_utest_i_)) { \
+			cc0::utest::ReportRangeFailure(AssertCount(), __LINE__, cc0_utest_i_, cc0_utest_a_[cc0_utest_i_], cc0_utest_b_[cc0_utest_i_]); \
+			return; \
+		} \
+	}
+
+/// @brief Exits a unit test if a buffer does not match a golden baseline file byte for byte.
+/// @param path The path of the baseline file.
+/// @param data The pointer to the buffer compared against the baseline.
+/// @param size The size of the buffer in bytes.
+/// @note Counts as a single assertion. The baseline is memory-mapped where the platform allows and the mapping is cached across tests, so repeated comparisons against one baseline pay the map cost once and never copy the file. On failure the first mismatching offset is reported with a hex window of both sides. When the run sets RunOptions::update_golden the baseline is rewritten from the buffer instead and the assertion passes.
+#define CC0_UTEST_ASSERT_GOLDEN(path, data, size) \
+	{ \
+		if (!AssertGolden((path), (data), (size), __LINE__)) { \
+			return; \
+		} \
 	}
 
 namespace cc0
@@ -51,8 +201,36 @@ namespace cc0
 		class UTestBase
 		{
 		private:
-			uint64_t m_assert_count;
-			bool     m_success;
+			/// @brief One recorded soft-assert failure: which assertion of the test failed and on which source line.
+			struct SoftFailure
+			{
+				uint64_t assert_count;
+				int      line;
+			};
+
+			static const uint32_t SOFT_FAILURE_CAPACITY = 8; ///< The capacity of the soft-failure ring buffer. Overflow overwrites the oldest entries; the total count is kept regardless.
+
+			uint64_t    m_assert_count;
+			SoftFailure m_soft[SOFT_FAILURE_CAPACITY];
+			uint32_t    m_soft_count;
+			bool        m_success;
+
+			/// @brief Compares two buffers of the same integral type as raw bytes, letting the C library compare wide blocks.
+			template < typename type_t >
+			static bool RangeEqual(const type_t *a, const type_t *b, uint64_t count, std::true_type) {
+				return std::memcmp(a, b, size_t(count) * sizeof(type_t)) == 0;
+			}
+
+			/// @brief Compares two buffers element by element. The branch-free inner comparison vectorizes for primitive element types.
+			template < typename a_t, typename b_t, typename tag_t >
+			static bool RangeEqual(const a_t *a, const b_t *b, uint64_t count, tag_t) {
+				for (uint64_t i = 0; i < count; ++i) {
+					if (!(a[i] == b[i])) {
+						return false;
+					}
+				}
+				return true;
+			}
 
 		protected:
 			/// @brief Increments the number of asserts performed.
@@ -62,13 +240,77 @@ namespace cc0
 			/// @return The current assert count.
 			uint64_t AssertCount( void ) const;
 
-			/// @brief Fails the test. 
+			/// @brief Fails the test.
 			void Fail( void );
 
+			/// @brief Fails the test and records the soft failure into the ring buffer without exiting the test.
+			/// @param line The source line of the failed expectation.
+			/// @sa CC0_UTEST_EXPECT
+			void RecordSoftFailure(int line);
+
+			/// @brief Compares two buffers element by element as a single assertion.
+			/// @param a The pointer to the first buffer.
+			/// @param b The pointer to the second buffer.
+			/// @param count The number of elements compared.
+			/// @param mismatch Receives the index of the first diverging element when the buffers differ.
+			/// @return True if every element pair compares equal.
+			/// @note Buffers of the same integral element type are compared as raw bytes so the C library can compare wide blocks; the first diverging index is only located by rescanning once the comparison has already failed.
+			/// @sa CC0_UTEST_ASSERT_RANGE
+			template < typename a_t, typename b_t >
+			bool AssertRange(const a_t *a, const b_t *b, uint64_t count, uint64_t &mismatch) {
+				IncrementAssertCount();
+				if (RangeEqual(a, b, count, std::integral_constant<bool, std::is_same<a_t,b_t>::value && std::is_integral<a_t>::value>())) {
+					return true;
+				}
+				for (uint64_t i = 0; i < count; ++i) {
+					if (!(a[i] == b[i])) {
+						mismatch = i;
+						break;
+					}
+				}
+				Fail();
+				return false;
+			}
+
+			/// @brief Compares a buffer against a golden baseline file byte for byte as a single assertion.
+			/// @param path The path of the baseline file.
+			/// @param data The pointer to the buffer compared against the baseline.
+			/// @param size The size of the buffer in bytes.
+			/// @param line The source line of the assertion.
+			/// @return True if the buffer matches the baseline exactly (or the run is updating baselines).
+			/// @note The baseline is memory-mapped on POSIX platforms and read in chunks elsewhere, compared with wide library comparisons either way; the first mismatching offset is only located by rescanning once the comparison has already failed. Mappings are cached across tests so one baseline maps once per run. When the run sets RunOptions::update_golden the baseline file is rewritten from the buffer instead of compared.
+			/// @sa CC0_UTEST_ASSERT_GOLDEN
+			bool AssertGolden(const char *path, const void *data, uint64_t size, int line);
+
+			/// @brief Compares two buffers element by element as a single assertion, allowing each pair to diverge by at most the given tolerance.
+			/// @param a The pointer to the first buffer.
+			/// @param b The pointer to the second buffer.
+			/// @param count The number of elements compared.
+			/// @param epsilon The maximum allowed absolute difference between an element pair.
+			/// @param mismatch Receives the index of the first element pair diverging by more than the tolerance.
+			/// @return True if every element pair is within the tolerance.
+			/// @sa CC0_UTEST_ASSERT_RANGE_NEAR
+			template < typename a_t, typename b_t, typename eps_t >
+			bool AssertRangeNear(const a_t *a, const b_t *b, uint64_t count, eps_t epsilon, uint64_t &mismatch) {
+				IncrementAssertCount();
+				for (uint64_t i = 0; i < count; ++i) {
+					const auto diff = a[i] < b[i] ? b[i] - a[i] : a[i] - b[i];
+					if (!(diff <= epsilon)) {
+						mismatch = i;
+						Fail();
+						return false;
+					}
+				}
+				return true;
+			}
+
 		public:
-			/// @brief Default constructor. 
+			/// @brief Default constructor.
 			UTestBase( void );
 
+			/// @brief Destructor. Summarizes the recorded soft failures, if any, so they report together once the test has run to completion.
+			~UTestBase( void );
+
 			/// @brief  Checks for success.
 			/// @return True if the test succeeded.
 			/// @sa Failed
@@ -80,26 +322,325 @@ namespace cc0
 			bool Failed( void ) const;
 		};
 
+		/// @brief Continues an FNV-1a 64-bit hash over a NUL-terminated string. Evaluatable at compile time so the registration macros bake test and context name hashes into the binary as constants.
+		/// @param s The string hashed.
+		/// @param h The hash continued, defaulting to the FNV offset basis.
+		/// @return The hash.
+		constexpr uint64_t HashName(const char *s, uint64_t h = 14695981039346656037ull)
+		{
+			return *s == 0 ? h : HashName(s + 1, (h ^ uint64_t(uint8_t(*s))) * 1099511628211ull);
+		}
+
+		/// @brief Measures a NUL-terminated string. Evaluatable at compile time.
+		/// @param s The string measured.
+		/// @param n The running count. Leave at the default.
+		/// @return The number of characters before the terminator.
+		constexpr uint32_t NameLength(const char *s, uint32_t n = 0)
+		{
+			return s[n] == 0 ? n : NameLength(s, n + 1);
+		}
+
+		/// @brief The base class for asynchronous unit tests driven in slices by the event-loop runner.
+		/// @note Do not use this class directly. Use CC0_UTEST_ASYNC_BEGIN and CC0_UTEST_ASYNC_END instead.
+		/// @sa CC0_UTEST_ASYNC_BEGIN
+		/// @sa CC0_UTEST_ASYNC_END
+		class UTestAsyncBase : public UTestBase
+		{
+		private:
+			bool m_pending;
+
+		protected:
+			/// @brief Marks the test finished. No further Step slices run.
+			void Done( void );
+
+		public:
+			/// @brief Default constructor.
+			UTestAsyncBase( void );
+
+			/// @brief Returns whether the test still has work to do.
+			/// @return True until Done has been called.
+			bool Pending( void ) const;
+		};
+
+		/// @brief The hooks letting a runner drive an asynchronous test in slices instead of to completion in one call.
+		/// @note Do not use this struct directly. CC0_UTEST_ASYNC_END generates and registers it.
+		struct AsyncTest
+		{
+			void *(*create)( void );       ///< Heap-allocates the test object without running any slice.
+			bool  (*step)(void *test);     ///< Runs one slice. Returns false once the test has finished or failed.
+			bool  (*succeeded)(void *test); ///< Returns whether the test finished without failure.
+			void  (*destroy)(void *test);  ///< Frees the test object.
+		};
+
+		/// @brief The descriptor letting a runner expand a parameterized test into one result row per table entry.
+		/// @note Do not use this struct directly. CC0_UTEST_PARAM_END generates and registers it.
+		struct ParamTest
+		{
+			bool (*run_one)(const void *param); ///< Runs the test body once on the given table entry.
+			const void *params;                 ///< The first entry of the parameter table.
+			uint32_t    count;                  ///< The number of entries in the table.
+			uint32_t    stride;                 ///< The size of one entry in bytes.
+		};
+
+		/// @brief The constant-initialized registration record of one test, of any flavor. The registration macros build one per test; the default backend hands it to AddTest from a static initializer, while the linker-section backend places it in a dedicated section that Run() walks, so registration costs no pre-main work at all.
+		/// @note Do not use this struct directly. The fields must all be constant expressions so the descriptor static-initializes.
+		struct TestDesc
+		{
+			bool (*test)();         ///< The wrapper running the test to completion in one call.
+			const AsyncTest *async; ///< The slice-driving hooks of an asynchronous test, or null.
+			const ParamTest *param; ///< The body and parameter table of a parameterized test, or null.
+			const char *name;       ///< The name of the test. Points at a string literal.
+			const char *context;    ///< The context grouping the test. Points at a string literal.
+			uint64_t context_hash;  ///< The precomputed HashName of the context.
+			uint64_t key;           ///< The precomputed stable hash of the test.
+			uint32_t name_len;      ///< The precomputed NameLength of the name.
+			uint32_t timeout_ms;    ///< The deadline of the test in milliseconds. 0 falls back to the default deadline of the run.
+			bool must_pass;         ///< Whether a failure halts the remaining tests of the context.
+		};
+
+		/// @brief The constant-initialized registration record of one context fixture, used by the linker-section backend the same way TestDesc is.
+		/// @note Do not use this struct directly. CC0_UTEST_FIXTURE generates it.
+		struct FixtureDesc
+		{
+			bool (*init)();      ///< The function run once before the first test in the context, or null.
+			bool (*cleanup)();   ///< The function run once after the last test in the context, or null.
+			const char *context; ///< The context the fixture belongs to. Points at a string literal.
+		};
+
+		/// @brief Adds the test a registration descriptor describes to the suite, dispatching on its flavor.
+		/// @param desc The descriptor. The name, context, hooks and table it points at must outlive the run.
+		/// @return Always returns TRUE.
+		/// @note Do not use this function directly. The registration macros generate the descriptors.
+		bool AddTest(const TestDesc &desc);
+
 		/// @brief Adds a test to the suite.
 		/// @param fn The function pointer to the wrapper running the test.
-		/// @param name The name of the test.
-		/// @param context An identifier to group the test together with other tests. CC0_UTEST_END automatically uses the current filename as context.
+		/// @param name The name of the test. Must outlive the run; the registry stores the pointer rather than a copy, so registration allocates no strings.
+		/// @param context An identifier to group the test together with other tests. CC0_UTEST_END automatically uses the current filename as context. Must outlive the run.
 		/// @param test_must_pass Controls whether the test must pass for the execution of the test suite to proceed.
+		/// @param timeout_ms The deadline in milliseconds after which the test is abandoned and recorded as a timeout failure. 0 falls back to the default deadline of the run.
+		/// @param context_hash The precomputed HashName of the context, or 0 to compute it at registration.
+		/// @param key The precomputed stable hash of the test, HashName(name, HashName(context)), or 0 to compute it at registration.
+		/// @param name_len The precomputed NameLength of the name, or 0 to measure it at registration.
 		/// @return Always returns TRUE.
-		/// @note Do not use this function directly. See instead CC0_UTEST_BEGIN and CC0_UTEST_END.
+		/// @note Do not use this function directly. See instead CC0_UTEST_BEGIN and CC0_UTEST_END, which fill the precomputed fields as compile-time constants.
 		/// @sa CC0_UTEST_BEGIN
 		/// @sa CC0_UTEST_END
-		bool AddTest(bool (*fn)(), const char *name, const char *context, bool test_must_pass);
+		bool AddTest(bool (*fn)(), const char *name, const char *context, bool test_must_pass, uint32_t timeout_ms = 0, uint64_t context_hash = 0, uint64_t key = 0, uint32_t name_len = 0);
+
+		/// @brief Adds an asynchronous test to the suite.
+		/// @param fn The function pointer to the wrapper driving the test to completion in one call, used by runners without an event loop.
+		/// @param hooks The hooks letting the event-loop runner drive the test in slices. Must outlive the run.
+		/// @param name The name of the test. Must outlive the run.
+		/// @param context An identifier to group the test together with other tests. Must outlive the run.
+		/// @param test_must_pass Controls whether the test must pass for the execution of the test suite to proceed.
+		/// @param timeout_ms The deadline in milliseconds. Applied only when the test runs through the wrapper; the event loop does not interrupt slices.
+		/// @param context_hash The precomputed HashName of the context, or 0 to compute it at registration.
+		/// @param key The precomputed stable hash of the test, or 0 to compute it at registration.
+		/// @param name_len The precomputed NameLength of the name, or 0 to measure it at registration.
+		/// @return Always returns TRUE.
+		/// @note Do not use this function directly. See instead CC0_UTEST_ASYNC_BEGIN and CC0_UTEST_ASYNC_END.
+		/// @sa CC0_UTEST_ASYNC_BEGIN
+		/// @sa CC0_UTEST_ASYNC_END
+		bool AddAsyncTest(bool (*fn)(), const AsyncTest *hooks, const char *name, const char *context, bool test_must_pass, uint32_t timeout_ms = 0, uint64_t context_hash = 0, uint64_t key = 0, uint32_t name_len = 0);
+
+		/// @brief Adds a parameterized test to the suite as a single registration covering every table entry.
+		/// @param fn The function pointer to the wrapper running every variant in one call, used by runners that do not expand variants into rows.
+		/// @param table The descriptor of the test body and its parameter table. Must outlive the run.
+		/// @param name The name of the test. Must outlive the run.
+		/// @param context An identifier to group the test together with other tests. Must outlive the run.
+		/// @param test_must_pass Controls whether the test must pass for the execution of the test suite to proceed.
+		/// @param timeout_ms The deadline in milliseconds, applied per variant when variants are expanded and to the whole table when run through the wrapper.
+		/// @param context_hash The precomputed HashName of the context, or 0 to compute it at registration.
+		/// @param key The precomputed stable hash of the test, or 0 to compute it at registration.
+		/// @param name_len The precomputed NameLength of the name, or 0 to measure it at registration.
+		/// @return Always returns TRUE.
+		/// @note Do not use this function directly. See instead CC0_UTEST_PARAM_BEGIN and CC0_UTEST_PARAM_END.
+		/// @sa CC0_UTEST_PARAM_BEGIN
+		/// @sa CC0_UTEST_PARAM_END
+		bool AddParamTest(bool (*fn)(), const ParamTest *table, const char *name, const char *context, bool test_must_pass, uint32_t timeout_ms = 0, uint64_t context_hash = 0, uint64_t key = 0, uint32_t name_len = 0);
+
+		/// @brief Registers the init and cleanup functions of a context.
+		/// @param init The function run once before the first test in the context. Returning false fails the context and skips its tests. May be null.
+		/// @param cleanup The function run once after the last test in the context. Returning false fails the context. May be null.
+		/// @param context An identifier grouping tests. CC0_UTEST_FIXTURE automatically uses the current filename as context.
+		/// @return Always returns TRUE.
+		/// @note Do not use this function directly. See instead CC0_UTEST_FIXTURE.
+		/// @sa CC0_UTEST_FIXTURE
+		bool AddFixture(bool (*init)(), bool (*cleanup)(), const char *context);
+
+		/// @brief Returns the slot holding the shared state of the given type, set up by a context init function and torn down by its cleanup function.
+		/// @return A reference to the pointer holding the state. Initially null.
+		/// @note The slot is keyed by type, so two contexts sharing a state type share the slot. Init functions run exactly once per context before any of its tests, so tests may read the slot without synchronization. Under process isolation each worker process holds its own copy.
+		/// @sa CC0_UTEST_FIXTURE
+		template < typename type_t >
+		type_t *&SharedState( void )
+		{
+			static type_t *state = nullptr;
+			return state;
+		}
+
+		/// @brief A read-only snapshot of one registered test, handed to the ForEachTest callback.
+		struct TestInfo
+		{
+			const char *name;        ///< The name of the test class.
+			const char *context;     ///< The context (source file) the test belongs to.
+			uint64_t    key;         ///< The stable hash of the context and test names, keying per-test data in the result cache and journal files.
+			uint64_t    wall_ns;     ///< Wall-clock duration of the last run of the test in this process, or 0 if it has not run.
+			uint64_t    cpu_ns;      ///< CPU time consumed by the last run of the test in this process, or 0 if it has not run.
+			uint32_t    timeout_ms;  ///< The registered deadline of the test in milliseconds, or 0 for the run default.
+			bool        must_pass;   ///< Whether a failure of this test aborts the remaining tests in its context.
+			int8_t      last_result; ///< -1 if the test has not run this process, otherwise 0 for fail and 1 for pass.
+		};
+
+		/// @brief Calls the callback once per registered test with a metadata snapshot, in registration order, without executing anything.
+		/// @param callback The function called per test.
+		/// @param user An opaque pointer passed through to every callback invocation.
+		/// @note Enumeration walks the registry AddTest builds and copies a handful of pointers and integers per test — no test function runs, no strings are copied, and no allocation happens, so listing tens of thousands of tests takes milliseconds. Tests registered via the linker-section backend are folded into the registry first.
+		void ForEachTest(void (*callback)(const TestInfo &info, void *user), void *user);
+
+		/// @brief Returns the stream test output is written to.
+		/// @return The output stream.
+		/// @note The stream is backed by an internal buffer that is written to the destination with a single write per test line or context rather than flushing per token like std::cout would. Tests should emit diagnostics through this stream so they order correctly with the test results.
+		/// @sa SetOutputStream
+		std::ostream &Log( void );
+
+		/// @brief Redirects all test output to the given destination.
+		/// @param stream The destination stream. Defaults to standard output.
+		/// @sa Log
+		void SetOutputStream(std::FILE *stream);
+
+		/// @brief Starts one diagnostic line and returns the stream its body is written to. In the console format the line continues the current test entry indented, in TAP it becomes a "#" comment line, and in JSONL the body is discarded so every emitted line stays a parseable record.
+		/// @return The stream the diagnostic body is written to.
+		/// @note Pair every call with EndReport on the returned stream so the line is terminated before the next structured record starts.
+		/// @sa EndReport
+		std::ostream &BeginReport( void );
+
+		/// @brief Ends a diagnostic line started by BeginReport, terminating it where the active format requires.
+		/// @param out The stream returned by the matching BeginReport call.
+		/// @sa BeginReport
+		void EndReport(std::ostream &out);
+
+		/// @brief Reports an allocation to the per-test memory counters. Call from the allocator under test.
+		/// @param bytes The size of the allocation.
+		/// @note The counters are thread-local, so concurrent workers attribute allocations to the test they are running without synchronization. The deltas are snapshotted around each test and reported when RunOptions::track_memory is set; calls are cheap either way.
+		/// @sa CountFree
+		void CountAlloc(uint64_t bytes);
+
+		/// @brief Reports a deallocation to the per-test memory counters. Call from the allocator under test.
+		/// @param bytes The size of the freed allocation.
+		/// @sa CountAlloc
+		void CountFree(uint64_t bytes);
+
+		/// @brief Formats and emits the diagnostic message of a failed assertion.
+		/// @param assert_count The running assert count of the test.
+		/// @param line The source line of the assertion.
+		/// @param l The left operand.
+		/// @param op The spelled-out comparison operator.
+		/// @param r The right operand.
+		/// @note Deliberately cold and out-of-line so the passing path of CC0_UTEST_ASSERT never touches the operands' stream operators.
+		template < typename l_t, typename r_t >
+#if defined(__GNUC__)
+		__attribute__((cold, noinline))
+#endif
+		void ReportAssertFailure(uint64_t assert_count, int line, const l_t &l, const char *op, const r_t &r)
+		{
+			std::ostream &out = BeginReport();
+			out << "#" << assert_count << " @" << line << ": <<" << l << " " << op << " " << r << ">> is false";
+			EndReport(out);
+		}
+
+		/// @brief Formats and emits the diagnostic message of a failed range assertion.
+		/// @param assert_count The running assert count of the test.
+		/// @param line The source line of the assertion.
+		/// @param index The index of the first diverging element.
+		/// @param l The element of the first buffer at the diverging index.
+		/// @param r The element of the second buffer at the diverging index.
+		/// @note Deliberately cold and out-of-line for the same reason as ReportAssertFailure.
+		template < typename l_t, typename r_t >
+#if defined(__GNUC__)
+		__attribute__((cold, noinline))
+#endif
+		void ReportRangeFailure(uint64_t assert_count, int line, uint64_t index, const l_t &l, const r_t &r)
+		{
+			std::ostream &out = BeginReport();
+			out << "#" << assert_count << " @" << line << ": ranges diverge at [" << index << "]: <<" << l << " == " << r << ">> is false";
+			EndReport(out);
+		}
+
+		/// @brief The formats test results are reported in.
+		enum OutputFormat
+		{
+			OUTPUT_CONSOLE, ///< The human-readable console format.
+			OUTPUT_TAP,     ///< Test Anything Protocol: one "ok"/"not ok" line per test streamed as it finishes, with a trailing plan line.
+			OUTPUT_JSONL    ///< One JSON object per line streamed as each test finishes, plus one summary object per context.
+		};
+
+		/// @brief Options controlling how the test suite is executed.
+		/// @sa Run
+		struct RunOptions
+		{
+			uint32_t thread_count;  ///< The number of workers executing tests. 1 executes tests serially in registration order. 0 creates one worker per hardware thread.
+			bool     isolate_tests; ///< If true, tests execute in a pool of preforked worker processes so a crashing test is recorded as a failure instead of taking down the run. Only available on POSIX platforms; elsewhere tests run in-process as if the flag was false.
+			uint32_t slowest_count; ///< The number of entries in the slowest-tests table printed after the run. 0 disables the table. Wall-clock and CPU time are recorded per test regardless.
+			uint32_t default_timeout_ms; ///< The deadline in milliseconds applied to tests that do not set their own. A timed-out test is abandoned and recorded as a timeout failure. 0 disables deadlines for tests without one.
+			const char *cache_file; ///< The path of the persistent result cache recording per-test outcome, duration, and a fingerprint of the test's code. Loaded before and saved after the run. null disables the cache. The fingerprint hashes a small window of the test function's machine code, bounded to the function's entry page, so it assumes code memory is readable; on platforms mapping code execute-only the cache cannot be used.
+			bool     incremental;   ///< If true, tests whose cached result is a pass and whose code fingerprint is unchanged are reported as cached passes without executing. Requires cache_file.
+			const char *journal_file; ///< The path of the write-ahead result journal: an append-only file of fixed records, keyed by test stable hash, recording a started entry before each test and its outcome after. When the file already holds records from an earlier interrupted run, tests with a recorded outcome are skipped and reported as resumed, and a test that started but never finished is reported as a crash. The journal is deleted when the run completes, so it only survives a crash. null disables journaling.
+			uint32_t journal_sync_every; ///< The journal is flushed and fsynced once this many records have accumulated, so a crash loses at most the last batch (those tests simply run again on resume). 0 picks a small default.
+			bool     failures_first; ///< If true and a result cache is loaded, tests with recorded failures run first (most consecutive failures first), the remainder runs slowest-first from the recorded durations, and registration order breaks ties. Contexts are reordered by the same ranking. Without a cache the order is unchanged.
+			bool     shuffle;       ///< If true, contexts and the tests within each context execute in a deterministic pseudo-random order derived from shuffle_seed, surfacing hidden order dependencies that registration order masks. The seed is printed before the run so a failing order can be replayed. Applied after failure-first scheduling, so combining the two shuffles away the failure-first ranking.
+			uint64_t shuffle_seed;  ///< The seed the shuffled order derives from. 0 derives a fresh seed from the clock; pass a previously printed seed to replay its exact order.
+			bool     bisect_order;  ///< If true and a shuffled run recorded a failure, the order is binary-searched for a minimal failing pair: the first failed test of the order and the single earlier test whose execution makes it fail. Probes re-invoke test bodies directly in this process, halving the candidate window each round, so the search costs O(log n) probe rounds and assumes the dependency reproduces under repetition. Console format only.
+			uint32_t max_failures;  ///< Stops starting further tests once this many failures have been recorded this run. Tests already running finish, their contexts still clean up, and skipped tests stay unreported. 0 disables the cutoff.
+			uint32_t retry_count;   ///< The number of extra attempts a failed test gets before its failure stands. Only the failed test re-executes, immediately and in place, so the suite keeps its warm state instead of the whole job restarting. A pass that needed a retry is reported as the distinct "flaky" verdict: it does not fail the run, but stays visible, and its rate is folded into the result cache so runs with a cache file list the worst offenders as quarantine candidates. 0 disables retries.
+			uint32_t retry_backoff_ms; ///< The delay before the first retry of a failed test, doubled for each further attempt. 0 retries immediately.
+			bool     track_memory;  ///< If true, the allocation count, peak bytes and leaked bytes reported through CountAlloc/CountFree are snapshotted around each test and printed next to its result (and included in JSONL output). Tests driven by the async event loop interleave on one thread and are not attributed.
+			bool     update_golden; ///< If true, golden-file assertions rewrite their baseline file from the buffer under test instead of comparing, and pass. Run once after an intended output change to refresh the baselines.
+			bool     progress;      ///< If true, a single self-updating status line is rendered to standard error: tests done out of total, failures so far, and an ETA seeded from the recorded durations of the loaded result cache and corrected by the observed pace. Redraws are throttled to a few per second, so the line adds no measurable I/O. Render the full per-test log into a file with SetOutputStream so the two do not interleave on one terminal.
+			const char *trace_file; ///< If non-null, the path a Chrome trace-event JSON profile of the run is written to. Every test and context init/cleanup call becomes a timed span attributed to the worker thread that ran it, so the file renders the suite as a flamegraph in chrome://tracing or Perfetto; gaps between spans are scheduler and reporting overhead. Spans are buffered in memory and written once after the run, so tracing does not perturb the timings it records. The preforked isolated runner attributes test spans in the parent; child-side fixture calls are not visible to it and are omitted.
+			bool     list_only;     ///< If true, the run prints the inventory of selected tests — names, contexts, must-pass flags, deadlines and historical durations from the loaded result cache — in the configured output format and returns without invoking a single test function. Sharding, filtering and context-prefix selection apply first, so tooling can plan against the exact set a real run would execute.
+			OutputFormat format;    ///< The format results are reported in. The structured formats stream one line per test as it finishes, formatted in the reusable output buffer without per-test allocation.
+			uint32_t shard_index;   ///< The index of the shard this process runs when the suite is split across machines. Must be less than shard_count; an out-of-range index fails the run instead of silently selecting no tests.
+			uint32_t shard_count;   ///< The number of shards the suite is split into. 0 or 1 runs everything. Tests are partitioned deterministically by their stable name hash, or balanced by recorded durations when the processes share a result cache.
+			const char *filter;     ///< A glob pattern selecting the tests to run by their full "context::name", supporting '*' (any run of characters) and '?' (any one character). A context where no test matches is skipped entirely, including its init and cleanup. null runs everything.
+			const char *context_prefix; ///< A '/'-separated path selecting the subtree of contexts to run. Context names are file paths, so "src/net/" runs every context under that directory; a skipped context is skipped entirely, including its init and cleanup. The prefix matches whole path segments, so "src/net" does not select "src/network/". null runs everything.
+			bool     context_rollup; ///< If true, a per-subtree rollup is printed after the run: every directory prefix of the context names that ran, with its aggregated pass/fail counts and wall-clock time. Console format only.
+			uint32_t bench_iterations; ///< The number of timed iterations each test runs in benchmark mode. 0 runs each test once as usual; any other value switches the run into benchmark mode, which executes serially in-process and reports min, median and p99 durations per test instead of a single result. Only the test invocation itself is timed; warmup, statistics and output happen outside the timed region. Cached results are never substituted for measurements.
+			uint32_t bench_warmup;  ///< The number of untimed warmup iterations each test runs before its timed iterations in benchmark mode.
+
+			/// @brief Defaults to serial in-process execution.
+			RunOptions( void );
+		};
 
 		/// @brief Runs all tests defined using CC0_UTEST_BEGIN and CC0_UTEST_END.
 		/// @return The return code of the execution. 0 for all-good, 1 for some failure.
 		int Run( void );
 
+		/// @brief Runs all tests defined using CC0_UTEST_BEGIN and CC0_UTEST_END using the provided options.
+		/// @param options The options controlling the execution.
+		/// @return The return code of the execution. 0 for all-good, 1 for some failure.
+		/// @note When more than one worker thread is requested tests are distributed across a pool of work-stealing worker threads and results are printed per context once the run completes. A failing must-pass test still aborts the remaining tests within its own context. Per-assert diagnostics may interleave between threads.
+		int Run(const RunOptions &options);
+
+		/// @brief Runs the subtree of contexts under the given '/'-separated path prefix.
+		/// @param context_prefix The path prefix selecting the subtree, e.g. "src/net/". Matches whole path segments of the context names.
+		/// @return The return code of the execution. 0 for all-good, 1 for some failure.
+		/// @note Equivalent to Run(RunOptions) with context_prefix set. Contexts outside the subtree are skipped entirely, including their init and cleanup.
+		int Run(const char *context_prefix);
+
 		/// @brief Runs the tests inside the specified contexts that have been defined using CC0_UTEST_BEGIN and CC0_UTEST_END.
 		/// @param contexts The names of the contexts run. CC0_UTEST_END automatically uses tests' filenames as context names so this is essentially the filenames of the source files containing the tests that should be executed.
 		/// @param count The number of contexts passed.
 		/// @return The return code of the execution. 0 for all-good, 1 for some failure.
 		int Run(const char **contexts, uint32_t count);
+
+		/// @brief Runs the shard of the test suite assigned to this process when the suite is split across machines.
+		/// @param shard_index The index of the shard to run. Must be less than shard_count.
+		/// @param shard_count The number of shards the suite is split into.
+		/// @return The return code of the execution. 0 for all-good, 1 for some failure.
+		/// @note Tests (not contexts) are partitioned deterministically by their stable name hash, so every machine derives the same near-equal split with no coordination. Equivalent to Run(RunOptions) with the shard fields set.
+		int Run(uint32_t shard_index, uint32_t shard_count);
 	}
 
 }